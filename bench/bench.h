@@ -0,0 +1,141 @@
+#pragma once
+
+// shared driver of the end to end benchmarks in this directory
+// every benchmark runs batch independent instances of a solver for a number of steps, the instances are spread over
+// the threads of a LinalgCtx. strong scaling keeps batch fixed, weak scaling grows it with the thread count
+// output is one csv line per run:
+// bench,mode,threads,batch,n,steps,pyvi,setup_s,step_s,speedup,efficiency,peak_rss_kb
+// step_s is the wall time of one step of the whole batch, speedup/efficiency are relative to the 1 thread run of the mode
+// peak_rss_kb is the high water mark of the process so far(it never decreases between runs)
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "../linalg.h"
+#include "../pyvisual.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+typedef struct BenchArgs
+{
+    // largest thread count of the sweep(1, 2, 4, ... and threads itself)
+    size_t threads;
+    // problem size of one instance
+    size_t n;
+    size_t steps;
+    // instances per run(per thread for weak scaling)
+    size_t batch;
+    // record instance 0 with PyVi and write it at the end of the run
+    int pyvi;
+    // "strong", "weak" or "both"
+    const char* mode;
+} BenchArgs;
+
+// runs args.steps steps of args.batch instances of size args.n on ctx
+// returns the wall time of the steps, setup(allocation and initialization) time goes to setup
+typedef double (*BenchRunFn)(LinalgCtx* ctx, BenchArgs args, double* setup);
+
+static inline double benchNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+// peak resident set size of the process in kilobytes
+static inline long benchPeakRssKb()
+{
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static inline void benchUsage(const char* program, BenchArgs defaults)
+{
+    printf("usage: %s [--threads N] [--n N] [--steps N] [--batch N] [--pyvi] [--mode strong|weak|both]\n", program);
+    printf("defaults: --threads %zu --n %zu --steps %zu --batch %zu --mode %s\n", defaults.threads, defaults.n, defaults.steps, defaults.batch, defaults.mode);
+}
+
+// parse the command line over defaults, exits on --help or invalid arguments
+static inline BenchArgs benchParseArgs(int argc, char** argv, BenchArgs defaults)
+{
+    BenchArgs args = defaults;
+    for(int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if(strcmp(arg, "--pyvi") == 0) args.pyvi = 1;
+        else if(strcmp(arg, "--threads") == 0 && value) args.threads = strtoul(value, NULL, 10), i++;
+        else if(strcmp(arg, "--n") == 0 && value) args.n = strtoul(value, NULL, 10), i++;
+        else if(strcmp(arg, "--steps") == 0 && value) args.steps = strtoul(value, NULL, 10), i++;
+        else if(strcmp(arg, "--batch") == 0 && value) args.batch = strtoul(value, NULL, 10), i++;
+        else if(strcmp(arg, "--mode") == 0 && value) args.mode = value, i++;
+        else
+        {
+            benchUsage(argv[0], defaults);
+            exit(strcmp(arg, "--help") == 0 ? 0 : 1);
+        }
+    }
+
+    if(strcmp(args.mode, "strong") != 0 && strcmp(args.mode, "weak") != 0 && strcmp(args.mode, "both") != 0)
+    {
+        benchUsage(argv[0], defaults);
+        exit(1);
+    }
+    if(args.threads == 0) args.threads = 1;
+    if(args.steps == 0) args.steps = 1;
+    if(args.batch == 0) args.batch = 1;
+    return args;
+}
+
+static inline void benchHeader()
+{
+    printf("bench,mode,threads,batch,n,steps,pyvi,setup_s,step_s,speedup,efficiency,peak_rss_kb\n");
+}
+
+// one scaling sweep, weak multiplies the batch by the thread count
+static inline void benchSweep(const char* name, BenchRunFn run, BenchArgs args, int weak)
+{
+    double base = 0.0;
+    for(size_t threads = 1;; threads = threads * 2 < args.threads ? threads * 2 : args.threads)
+    {
+        BenchArgs cur = args;
+        cur.batch = weak ? args.batch * threads : args.batch;
+
+        LinalgCtx* ctx = linalgCtxInitA(threads, NULL);
+        if(!ctx) return;
+
+        double setup = 0.0;
+        double total = run(ctx, cur, &setup);
+        freeLinalgCtx(ctx);
+
+        double step = total / (double)cur.steps;
+        if(threads == 1) base = step;
+        // weak scaling is ideal if the step time stays the same
+        double speedup = weak ? base * (double)threads / step : base / step;
+
+        printf("%s,%s,%zu,%zu,%zu,%zu,%d,%.6f,%.9f,%.3f,%.3f,%ld\n", name, weak ? "weak" : "strong", threads, cur.batch, cur.n, cur.steps,
+               cur.pyvi, setup, step, speedup, speedup / (double)threads, benchPeakRssKb());
+        fflush(stdout);
+
+        if(threads >= args.threads) break;
+    }
+}
+
+// run the strong and/or weak sweeps selected by args.mode
+static inline void benchRun(const char* name, BenchRunFn run, BenchArgs args)
+{
+    benchHeader();
+    if(strcmp(args.mode, "weak") != 0) benchSweep(name, run, args, 0);
+    if(strcmp(args.mode, "strong") != 0) benchSweep(name, run, args, 1);
+}
@@ -0,0 +1,103 @@
+// 1D implicit diffusion time-stepper on MatTriDiag
+// batch rods with different diffusivities share one discrete laplacian, every step solves
+// (A + sigma I)u' = sigma u with triDiagSolveShifted(sigma = 1 / (dt D)), the rods are spread over the threads
+// gcc -O2 -march=native bench/diffusion.c linalg-src/*.c pyvi-src/*.c -lm -pthread -o bench_diffusion
+
+#include "bench.h"
+
+#include <math.h>
+
+typedef struct DiffusionBatch
+{
+    MatTriDiag A;
+    Vec* u;
+    Vec* scratch;
+    double* sigma;
+    PyViSec section;
+    int pyvi;
+} DiffusionBatch;
+
+static void diffusionStep(void* data, size_t begin, size_t end, size_t thread)
+{
+    DiffusionBatch* batch = data;
+    (void)thread;
+
+    for(size_t r = begin; r < end; r++)
+    {
+        vecScale(batch->sigma[r], batch->u[r], &batch->u[r]);
+        triDiagSolveShifted(batch->A, batch->sigma[r], &batch->u[r], &batch->scratch[r]);
+
+        // only instance 0 is recorded, so the PyVi is only touched by one thread
+        if(r == 0 && batch->pyvi) pyviSectionPush(batch->section, batch->u[0]);
+    }
+}
+
+static double diffusionRun(LinalgCtx* ctx, BenchArgs args, double* setup)
+{
+    double t0 = benchNow();
+    size_t n = args.n;
+    double h = 1.0 / (double)(n + 1), dt = 1e-4;
+
+    DiffusionBatch batch;
+    batch.pyvi = args.pyvi;
+    // -u'' with dirichlet boundaries
+    batch.A = triDiagInitA(-1.0 / (h * h), n);
+    for(size_t i = 0; i < n; i++) VEC_INDEX(batch.A.diagonal, i) = 2.0 / (h * h);
+
+    batch.u = malloc(args.batch * sizeof(Vec));
+    batch.scratch = malloc(args.batch * sizeof(Vec));
+    batch.sigma = malloc(args.batch * sizeof(double));
+    for(size_t r = 0; r < args.batch; r++)
+    {
+        batch.u[r] = vecInitZerosA(n);
+        batch.scratch[r] = vecInitZerosA(n);
+        batch.sigma[r] = 1.0 / (dt * (0.5 + (double)r / (double)args.batch));
+        for(size_t i = 0; i < n; i++) VEC_INDEX(batch.u[r], i) = sin(M_PI * (double)(i + 1) * h) + 0.1 * sin(17.0 * M_PI * (double)(i + 1) * h);
+    }
+
+    PyVi pyvi;
+    Vec axis = nullVec;
+    if(args.pyvi)
+    {
+        pyvi = pyviInitA("bench_diffusion.pyvi");
+        axis = vecInitZerosA(n);
+        for(size_t i = 0; i < n; i++) VEC_INDEX(axis, i) = (double)(i + 1) * h;
+        batch.section = pyviCreateSection(&pyvi, "u", pyviCreateParameter(&pyvi, "x", axis));
+    }
+    *setup = benchNow() - t0;
+
+    double t1 = benchNow();
+    for(size_t s = 0; s < args.steps; s++)
+    {
+        linalgParallelFor(ctx, 0, args.batch, 1, diffusionStep, &batch);
+    }
+    // writing is part of the cost of recording
+    if(args.pyvi) pyviWrite(pyvi);
+    double elapsed = benchNow() - t1;
+
+    if(args.pyvi)
+    {
+        freePyVi(&pyvi);
+        freeVec(&axis);
+    }
+    for(size_t r = 0; r < args.batch; r++)
+    {
+        freeVec(&batch.u[r]);
+        freeVec(&batch.scratch[r]);
+    }
+    free(batch.u);
+    free(batch.scratch);
+    free(batch.sigma);
+    freeMatTriDiag(&batch.A);
+
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    BenchArgs defaults = { 8, 100000, 100, 8, 0, "both" };
+    BenchArgs args = benchParseArgs(argc, argv, defaults);
+
+    benchRun("diffusion", diffusionRun, args);
+    return 0;
+}
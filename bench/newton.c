@@ -0,0 +1,167 @@
+// 2x2 coupled reaction-diffusion Newton solve on MatBlock2TD
+// every step is one implicit euler step of u_t = u'' - u^3 + v, v_t = v'' + u - v solved with blkTriDiagNewton,
+// batch independent problems(with different reaction rates) are spread over the threads
+// gcc -O2 -march=native bench/newton.c linalg-src/*.c pyvi-src/*.c -lm -pthread -o bench_newton
+
+#include "bench.h"
+
+#include <math.h>
+
+typedef struct NewtonProblem
+{
+    size_t n;
+    double h;
+    double dt;
+    double rate;
+    // state at the start of the step
+    Vec2* prev;
+} NewtonProblem;
+
+typedef struct NewtonBatch
+{
+    NewtonProblem* problems;
+    Vec2** x;
+    MatBlock2TD* J;
+    Vec2** work;
+    BlkNewtonOptions opts;
+    PyViNewton record;
+    int pyvi;
+    size_t iterations;
+} NewtonBatch;
+
+static int newtonResidual(void* user, const Vec2* x, Vec2* F)
+{
+    NewtonProblem* p = user;
+    double c = p->dt / (p->h * p->h);
+    for(size_t i = 0; i < p->n; i++)
+    {
+        Vec2 l = i > 0 ? x[i - 1] : (Vec2){ { 0.0, 0.0 } };
+        Vec2 r = i + 1 < p->n ? x[i + 1] : (Vec2){ { 0.0, 0.0 } };
+        double u = x[i].x[0], v = x[i].x[1];
+
+        F[i].x[0] = u - p->prev[i].x[0] + c * (2.0 * u - l.x[0] - r.x[0]) + p->dt * p->rate * (u * u * u - v);
+        F[i].x[1] = v - p->prev[i].x[1] + c * (2.0 * v - l.x[1] - r.x[1]) + p->dt * (v - u);
+    }
+    return LINALG_OK;
+}
+
+static int newtonJacobian(void* user, const Vec2* x, MatBlock2TD* J)
+{
+    NewtonProblem* p = user;
+    double c = p->dt / (p->h * p->h);
+    for(size_t i = 0; i < p->n; i++)
+    {
+        double u = x[i].x[0];
+        J->diagonal[i] = (Block2){ { { 1.0 + 2.0 * c + 3.0 * p->dt * p->rate * u * u, -p->dt * p->rate }, { -p->dt, 1.0 + 2.0 * c + p->dt } } };
+        J->subdiagonal[i] = (Block2){ { { -c, 0.0 }, { 0.0, -c } } };
+        J->superdiagonal[i] = J->subdiagonal[i];
+    }
+    return LINALG_OK;
+}
+
+static void newtonStep(void* data, size_t begin, size_t end, size_t thread)
+{
+    NewtonBatch* batch = data;
+    (void)thread;
+
+    for(size_t b = begin; b < end; b++)
+    {
+        NewtonProblem* p = &batch->problems[b];
+        memcpy(p->prev, batch->x[b], p->n * sizeof(Vec2));
+
+        BlkNewtonOptions opts = batch->opts;
+        // only instance 0 is recorded, so the PyVi is only touched by one thread
+        if(b == 0 && batch->pyvi)
+        {
+            opts.monitor = pyviNewtonMonitor;
+            opts.monitor_user = &batch->record;
+        }
+
+        BlkNewtonResult result;
+        blkTriDiagNewton(newtonResidual, newtonJacobian, p, batch->x[b], &batch->J[b], batch->work[b], opts, &result);
+        if(b == 0) batch->iterations += result.iterations;
+    }
+}
+
+static double newtonRun(LinalgCtx* ctx, BenchArgs args, double* setup)
+{
+    double t0 = benchNow();
+    size_t n = args.n;
+
+    NewtonBatch batch;
+    batch.pyvi = args.pyvi;
+    batch.iterations = 0;
+    batch.opts = blkNewtonDefaultOptions();
+    batch.problems = malloc(args.batch * sizeof(NewtonProblem));
+    batch.x = malloc(args.batch * sizeof(Vec2*));
+    batch.J = malloc(args.batch * sizeof(MatBlock2TD));
+    batch.work = malloc(args.batch * sizeof(Vec2*));
+
+    for(size_t b = 0; b < args.batch; b++)
+    {
+        NewtonProblem* p = &batch.problems[b];
+        p->n = n;
+        p->h = 1.0 / (double)(n + 1);
+        p->dt = 1e-3;
+        p->rate = 1.0 + 10.0 * (double)b / (double)args.batch;
+        p->prev = malloc(n * sizeof(Vec2));
+
+        batch.x[b] = malloc(n * sizeof(Vec2));
+        batch.J[b] = blkTriDiagInitZeroA(n);
+        batch.work[b] = malloc(4 * n * sizeof(Vec2));
+        for(size_t i = 0; i < n; i++)
+        {
+            double s = sin(M_PI * (double)(i + 1) * p->h);
+            batch.x[b][i] = (Vec2){ { 2.0 * s, s } };
+        }
+    }
+
+    PyVi pyvi;
+    Vec axis = nullVec;
+    if(args.pyvi)
+    {
+        pyvi = pyviInitA("bench_newton.pyvi");
+        axis = vecInitZerosA(2 * n);
+        for(size_t i = 0; i < 2 * n; i++) VEC_INDEX(axis, i) = (double)i;
+        batch.record = pyviNewtonInit(&pyvi, "x", "F", pyviCreateParameter(&pyvi, "unknown", axis));
+    }
+    *setup = benchNow() - t0;
+
+    double t1 = benchNow();
+    for(size_t s = 0; s < args.steps; s++)
+    {
+        linalgParallelFor(ctx, 0, args.batch, 1, newtonStep, &batch);
+    }
+    if(args.pyvi) pyviWrite(pyvi);
+    double elapsed = benchNow() - t1;
+    // stderr keeps the csv on stdout clean
+    fprintf(stderr, "newton: instance 0 took %zu iterations over %zu steps\n", batch.iterations, args.steps);
+
+    if(args.pyvi)
+    {
+        freePyVi(&pyvi);
+        freeVec(&axis);
+    }
+    for(size_t b = 0; b < args.batch; b++)
+    {
+        free(batch.problems[b].prev);
+        free(batch.x[b]);
+        freeMatBlock2TD(&batch.J[b]);
+        free(batch.work[b]);
+    }
+    free(batch.problems);
+    free(batch.x);
+    free(batch.J);
+    free(batch.work);
+
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    BenchArgs defaults = { 8, 20000, 20, 8, 0, "both" };
+    BenchArgs args = benchParseArgs(argc, argv, defaults);
+
+    benchRun("newton", newtonRun, args);
+    return 0;
+}
@@ -0,0 +1,121 @@
+// dense mat2DSqSolve sweep
+// every step solves batch independent nxn systems with gaussian elimination(including building the augmented matrix),
+// the systems are spread over the threads. --n is the largest size, the sweep runs n/8, n/4, n/2 and n
+// gcc -O2 -march=native bench/sqsolve.c linalg-src/*.c pyvi-src/*.c -lm -pthread -o bench_sqsolve
+
+#include "bench.h"
+
+#include <math.h>
+
+typedef struct SqSolveBatch
+{
+    Mat2d* A;
+    Vec* b;
+    Vec* y;
+    Mat2d* scratch;
+    size_t** order;
+    PyViSec section;
+    int pyvi;
+} SqSolveBatch;
+
+static void sqSolveStep(void* data, size_t begin, size_t end, size_t thread)
+{
+    SqSolveBatch* batch = data;
+    (void)thread;
+
+    for(size_t s = begin; s < end; s++)
+    {
+        mat2DSqSolve(batch->A[s], batch->b[s], &batch->scratch[s], batch->order[s], &batch->y[s]);
+
+        // only instance 0 is recorded, so the PyVi is only touched by one thread
+        if(s == 0 && batch->pyvi) pyviSectionPush(batch->section, batch->y[0]);
+    }
+}
+
+static double sqSolveRun(LinalgCtx* ctx, BenchArgs args, double* setup)
+{
+    double t0 = benchNow();
+    size_t n = args.n;
+
+    SqSolveBatch batch;
+    batch.pyvi = args.pyvi;
+    batch.A = malloc(args.batch * sizeof(Mat2d));
+    batch.b = malloc(args.batch * sizeof(Vec));
+    batch.y = malloc(args.batch * sizeof(Vec));
+    batch.scratch = malloc(args.batch * sizeof(Mat2d));
+    batch.order = malloc(args.batch * sizeof(size_t*));
+
+    for(size_t s = 0; s < args.batch; s++)
+    {
+        // diagonally dominant, so elimination is stable without help
+        batch.A[s] = mat2DInitZerosA(n, n);
+        for(size_t i = 0; i < n; i++)
+        {
+            for(size_t j = 0; j < n; j++) *mat2DRef(batch.A[s], i, j) = sin((double)(i * n + j + s));
+            *mat2DRef(batch.A[s], i, i) += (double)n;
+        }
+        batch.b[s] = vecInitOnesA(n);
+        batch.y[s] = vecInitZerosA(n);
+        batch.scratch[s] = mat2DInitZerosA(n, n + 1);
+        batch.order[s] = malloc(n * sizeof(size_t));
+    }
+
+    PyVi pyvi;
+    Vec axis = nullVec;
+    if(args.pyvi)
+    {
+        pyvi = pyviInitA("bench_sqsolve.pyvi");
+        axis = vecInitZerosA(n);
+        for(size_t i = 0; i < n; i++) VEC_INDEX(axis, i) = (double)i;
+        batch.section = pyviCreateSection(&pyvi, "y", pyviCreateParameter(&pyvi, "row", axis));
+    }
+    *setup = benchNow() - t0;
+
+    double t1 = benchNow();
+    for(size_t s = 0; s < args.steps; s++)
+    {
+        linalgParallelFor(ctx, 0, args.batch, 1, sqSolveStep, &batch);
+    }
+    if(args.pyvi) pyviWrite(pyvi);
+    double elapsed = benchNow() - t1;
+
+    if(args.pyvi)
+    {
+        freePyVi(&pyvi);
+        freeVec(&axis);
+    }
+    for(size_t s = 0; s < args.batch; s++)
+    {
+        freeMat2D(&batch.A[s]);
+        freeVec(&batch.b[s]);
+        freeVec(&batch.y[s]);
+        freeMat2D(&batch.scratch[s]);
+        free(batch.order[s]);
+    }
+    free(batch.A);
+    free(batch.b);
+    free(batch.y);
+    free(batch.scratch);
+    free(batch.order);
+
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    BenchArgs defaults = { 8, 512, 5, 8, 0, "both" };
+    BenchArgs args = benchParseArgs(argc, argv, defaults);
+
+    benchHeader();
+    size_t largest = args.n;
+    // halving down from largest keeps it in the sweep even if it is not a power of two
+    for(size_t shift = 4; shift-- > 0;)
+    {
+        size_t n = largest >> shift;
+        if(n == 0) continue;
+        args.n = n;
+        if(strcmp(args.mode, "weak") != 0) benchSweep("sqsolve", sqSolveRun, args, 0);
+        if(strcmp(args.mode, "strong") != 0) benchSweep("sqsolve", sqSolveRun, args, 1);
+    }
+    return 0;
+}
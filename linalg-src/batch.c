@@ -0,0 +1,305 @@
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+
+// items of a batch are processed LA_BATCH_LANES at a time, one item per vector lane
+// so the straight line KxK code below runs on whole registers
+#if defined(__GNUC__)
+// one native register wide
+#if defined(__AVX512F__)
+#define LA_BATCH_LANES 8
+#elif defined(__AVX__)
+#define LA_BATCH_LANES 4
+#else
+#define LA_BATCH_LANES 2
+#endif
+// the kernels only run fast if every helper is inlined into them(K becomes a constant)
+#define LA_BATCH_INLINE static inline __attribute__((always_inline))
+// fully unroll the loops over K, so the matrices stay in registers
+#define LA_BATCH_UNROLL _Pragma("GCC unroll 16")
+typedef double batchVec __attribute__((vector_size(LA_BATCH_LANES * sizeof(double))));
+typedef long long batchMask __attribute__((vector_size(LA_BATCH_LANES * sizeof(double))));
+
+LA_BATCH_INLINE batchVec batchSelect(batchMask m, batchVec a, batchVec b)
+{
+    return (batchVec)(((batchMask)a & m) | ((batchMask)b & ~m));
+}
+#else
+#define LA_BATCH_LANES 1
+#define LA_BATCH_INLINE static inline
+#define LA_BATCH_UNROLL
+typedef double batchVec;
+typedef int batchMask;
+
+LA_BATCH_INLINE batchVec batchSelect(batchMask m, batchVec a, batchVec b)
+{
+    return m ? a : b;
+}
+#endif
+
+LA_BATCH_INLINE batchVec batchAbs(batchVec x)
+{
+    return batchSelect(x < 0, -x, x);
+}
+
+// load the KxK matrices [b, b + n) of a SoA buffer into registers
+// missing lanes(n < LA_BATCH_LANES) are padded with identity matrices, so they never produce inf/nan
+LA_BATCH_INLINE void batchLoadMat(batchVec* dst, const double* src, size_t stride, size_t K, size_t b, size_t n)
+{
+    LA_BATCH_UNROLL
+    for(size_t c = 0; c < K * K; c++)
+    {
+        // constant size copies compile to plain vector loads
+        if(n == LA_BATCH_LANES)
+        {
+            memcpy(&dst[c], src + c * stride + b, sizeof(batchVec));
+            continue;
+        }
+
+        double lanes[LA_BATCH_LANES];
+        for(size_t l = 0; l < LA_BATCH_LANES; l++) lanes[l] = l < n ? src[c * stride + b + l] : (c / K == c % K) ? 1.0 : 0.0;
+        memcpy(&dst[c], lanes, sizeof(batchVec));
+    }
+}
+// load the K vectors [b, b + n) of a SoA buffer into registers, padded with zeros
+LA_BATCH_INLINE void batchLoadVec(batchVec* dst, const double* src, size_t stride, size_t K, size_t b, size_t n)
+{
+    LA_BATCH_UNROLL
+    for(size_t c = 0; c < K; c++)
+    {
+        if(n == LA_BATCH_LANES)
+        {
+            memcpy(&dst[c], src + c * stride + b, sizeof(batchVec));
+            continue;
+        }
+
+        double lanes[LA_BATCH_LANES];
+        for(size_t l = 0; l < LA_BATCH_LANES; l++) lanes[l] = l < n ? src[c * stride + b + l] : 0.0;
+        memcpy(&dst[c], lanes, sizeof(batchVec));
+    }
+}
+// store ncomp components of the items [b, b + n) back into a SoA buffer
+LA_BATCH_INLINE void batchStore(double* dst, size_t stride, const batchVec* src, size_t ncomp, size_t b, size_t n)
+{
+    LA_BATCH_UNROLL
+    for(size_t c = 0; c < ncomp; c++)
+    {
+        if(n == LA_BATCH_LANES)
+        {
+            memcpy(dst + c * stride + b, &src[c], sizeof(batchVec));
+            continue;
+        }
+
+        double lanes[LA_BATCH_LANES];
+        memcpy(lanes, &src[c], sizeof(batchVec));
+        for(size_t l = 0; l < n; l++) dst[c * stride + b + l] = lanes[l];
+    }
+}
+
+// gaussian elimination on LA_BATCH_LANES KxK matrices a with m right hand side columns rhs(K*m components)
+// rows are swapped branchless per lane(partial pivoting)
+// if rhs is NULL only the entries below the diagonal are eliminated(enough for the determinant)
+// else the elimination is gauss-jordan, leaving A^-1 rhs in rhs
+// returns the determinant of every lane
+LA_BATCH_INLINE batchVec batchEliminate(size_t K, batchVec* a, batchVec* rhs, size_t m)
+{
+    batchVec det = a[0] * 0 + 1;
+
+    LA_BATCH_UNROLL
+    for(size_t k = 0; k < K; k++)
+    {
+        // after this, row k holds the largest pivot of every lane
+        LA_BATCH_UNROLL
+        for(size_t r = k + 1; r < K; r++)
+        {
+            batchMask swap = batchAbs(a[r * K + k]) > batchAbs(a[k * K + k]);
+
+            LA_BATCH_UNROLL
+            for(size_t c = k; c < K; c++)
+            {
+                batchVec x = a[k * K + c], y = a[r * K + c];
+                a[k * K + c] = batchSelect(swap, y, x);
+                a[r * K + c] = batchSelect(swap, x, y);
+            }
+            LA_BATCH_UNROLL
+            for(size_t c = 0; rhs && c < m; c++)
+            {
+                batchVec x = rhs[k * m + c], y = rhs[r * m + c];
+                rhs[k * m + c] = batchSelect(swap, y, x);
+                rhs[r * m + c] = batchSelect(swap, x, y);
+            }
+            det = batchSelect(swap, -det, det);
+        }
+
+        batchVec pivot = a[k * K + k];
+        det *= pivot;
+
+        if(rhs)
+        {
+            // normalize the pivot row
+            batchVec inv = 1.0 / pivot;
+            LA_BATCH_UNROLL
+            for(size_t c = k + 1; c < K; c++) a[k * K + c] *= inv;
+            LA_BATCH_UNROLL
+            for(size_t c = 0; c < m; c++) rhs[k * m + c] *= inv;
+        }
+
+        LA_BATCH_UNROLL
+        for(size_t r = rhs ? 0 : k + 1; r < K; r++)
+        {
+            if(r == k) continue;
+
+            batchVec f = rhs ? a[r * K + k] : a[r * K + k] / pivot;
+            LA_BATCH_UNROLL
+            for(size_t c = k + 1; c < K; c++) a[r * K + c] -= f * a[k * K + c];
+            LA_BATCH_UNROLL
+            for(size_t c = 0; rhs && c < m; c++) rhs[r * m + c] -= f * rhs[k * m + c];
+        }
+    }
+
+    return det;
+}
+
+// defines all the Block{K}Batch kernels declared by LINALG_BLK_BATCH_DECLARE(K)
+#define LA_BLK_BATCH_DEFINE(K) \
+Block##K##Batch blk##K##BatchInitA(size_t count) \
+{ \
+    LINALG_TRACE_SCOPE(count, K, 0); \
+    LINALG_ASSERT_ERROR(count == 0, ((Block##K##Batch){ NULL, 0, 0 }), "invalid zero size batch requested!"); \
+    Block##K##Batch batch = { (double*)calloc(K * K * count, sizeof(double)), count, count }; \
+    LINALG_ASSERT_ERROR(!batch.mat, batch, "unkown error occured when allocation memory!"); \
+    return batch; \
+} \
+Vec##K##Batch vec##K##BatchInitA(size_t count) \
+{ \
+    LINALG_TRACE_SCOPE(count, K, 0); \
+    LINALG_ASSERT_ERROR(count == 0, ((Vec##K##Batch){ NULL, 0, 0 }), "invalid zero size batch requested!"); \
+    Vec##K##Batch batch = { (double*)calloc(K * count, sizeof(double)), count, count }; \
+    LINALG_ASSERT_ERROR(!batch.x, batch, "unkown error occured when allocation memory!"); \
+    return batch; \
+} \
+int blk##K##BatchMul(Block##K##Batch A, Block##K##Batch B, Block##K##Batch* result) \
+{ \
+    LINALG_TRACE_SCOPE(A.count, K, 0); \
+    LINALG_ASSERT_ERROR(!result || !result->mat, LINALG_ERROR, "result batch is null!"); \
+    LINALG_ASSERT_ERROR(!A.mat || !B.mat, LINALG_ERROR, "input batch/es is/are null!"); \
+    LINALG_ASSERT_ERROR(A.count != B.count || A.count != result->count, LINALG_ERROR, "batch sizes %zu, %zu and %zu do not match!", A.count, B.count, result->count); \
+    for(size_t b = 0; b < A.count; b += LA_BATCH_LANES) \
+    { \
+        size_t n = A.count - b < LA_BATCH_LANES ? A.count - b : LA_BATCH_LANES; \
+        batchVec a[K * K], bm[K * K], r[K * K]; \
+        batchLoadMat(a, A.mat, A.stride, K, b, n); \
+        batchLoadMat(bm, B.mat, B.stride, K, b, n); \
+        LA_BATCH_UNROLL \
+        for(size_t i = 0; i < K; i++) \
+        { \
+            LA_BATCH_UNROLL \
+            for(size_t j = 0; j < K; j++) \
+            { \
+                batchVec sum = a[i * K] * bm[j]; \
+                LA_BATCH_UNROLL \
+                for(size_t k = 1; k < K; k++) sum += a[i * K + k] * bm[k * K + j]; \
+                r[i * K + j] = sum; \
+            } \
+        } \
+        batchStore(result->mat, result->stride, r, K * K, b, n); \
+    } \
+    return LINALG_OK; \
+} \
+int blk##K##BatchTransform(Block##K##Batch A, Vec##K##Batch x, Vec##K##Batch* y) \
+{ \
+    LINALG_TRACE_SCOPE(A.count, K, 0); \
+    LINALG_ASSERT_ERROR(!y || !y->x, LINALG_ERROR, "result batch is null!"); \
+    LINALG_ASSERT_ERROR(!A.mat || !x.x, LINALG_ERROR, "input batch/es is/are null!"); \
+    LINALG_ASSERT_ERROR(A.count != x.count || A.count != y->count, LINALG_ERROR, "batch sizes %zu, %zu and %zu do not match!", A.count, x.count, y->count); \
+    for(size_t b = 0; b < A.count; b += LA_BATCH_LANES) \
+    { \
+        size_t n = A.count - b < LA_BATCH_LANES ? A.count - b : LA_BATCH_LANES; \
+        batchVec a[K * K], v[K], r[K]; \
+        batchLoadMat(a, A.mat, A.stride, K, b, n); \
+        batchLoadVec(v, x.x, x.stride, K, b, n); \
+        LA_BATCH_UNROLL \
+        for(size_t i = 0; i < K; i++) \
+        { \
+            batchVec sum = a[i * K] * v[0]; \
+            LA_BATCH_UNROLL \
+            for(size_t k = 1; k < K; k++) sum += a[i * K + k] * v[k]; \
+            r[i] = sum; \
+        } \
+        batchStore(y->x, y->stride, r, K, b, n); \
+    } \
+    return LINALG_OK; \
+} \
+int blk##K##BatchInverse(Block##K##Batch A, Block##K##Batch* result) \
+{ \
+    LINALG_TRACE_SCOPE(A.count, K, 0); \
+    LINALG_ASSERT_ERROR(!result || !result->mat, LINALG_ERROR, "result batch is null!"); \
+    LINALG_ASSERT_ERROR(!A.mat, LINALG_ERROR, "input batch is null!"); \
+    LINALG_ASSERT_ERROR(A.count != result->count, LINALG_ERROR, "batch sizes %zu and %zu do not match!", A.count, result->count); \
+    for(size_t b = 0; b < A.count; b += LA_BATCH_LANES) \
+    { \
+        size_t n = A.count - b < LA_BATCH_LANES ? A.count - b : LA_BATCH_LANES; \
+        batchVec a[K * K], r[K * K]; \
+        batchLoadMat(a, A.mat, A.stride, K, b, n); \
+        LA_BATCH_UNROLL \
+        for(size_t c = 0; c < K * K; c++) r[c] = a[0] * 0 + ((c / K == c % K) ? 1.0 : 0.0); \
+        batchEliminate(K, a, r, K); \
+        batchStore(result->mat, result->stride, r, K * K, b, n); \
+    } \
+    return LINALG_OK; \
+} \
+int blk##K##BatchDeterminant(Block##K##Batch A, Vec* det) \
+{ \
+    LINALG_TRACE_SCOPE(A.count, K, 0); \
+    LINALG_ASSERT_ERROR(!det || !det->x, LINALG_ERROR, "result vector is null!"); \
+    LINALG_ASSERT_ERROR(!A.mat, LINALG_ERROR, "input batch is null!"); \
+    LINALG_ASSERT_ERROR(A.count != det->len, LINALG_ERROR, "batch size %zu does not match vec(%zu)!", A.count, det->len); \
+    for(size_t b = 0; b < A.count; b += LA_BATCH_LANES) \
+    { \
+        size_t n = A.count - b < LA_BATCH_LANES ? A.count - b : LA_BATCH_LANES; \
+        batchVec a[K * K]; \
+        batchLoadMat(a, A.mat, A.stride, K, b, n); \
+        batchVec d = batchEliminate(K, a, NULL, 0); \
+        double lanes[LA_BATCH_LANES]; \
+        memcpy(lanes, &d, sizeof(batchVec)); \
+        for(size_t l = 0; l < n; l++) det->x[(b + l) * det->offset] = lanes[l]; \
+    } \
+    return LINALG_OK; \
+} \
+int blk##K##BatchSolve(Block##K##Batch A, Vec##K##Batch y, Vec##K##Batch* x) \
+{ \
+    LINALG_TRACE_SCOPE(A.count, K, 0); \
+    LINALG_ASSERT_ERROR(!x || !x->x, LINALG_ERROR, "result batch is null!"); \
+    LINALG_ASSERT_ERROR(!A.mat || !y.x, LINALG_ERROR, "input batch/es is/are null!"); \
+    LINALG_ASSERT_ERROR(A.count != y.count || A.count != x->count, LINALG_ERROR, "batch sizes %zu, %zu and %zu do not match!", A.count, y.count, x->count); \
+    for(size_t b = 0; b < A.count; b += LA_BATCH_LANES) \
+    { \
+        size_t n = A.count - b < LA_BATCH_LANES ? A.count - b : LA_BATCH_LANES; \
+        batchVec a[K * K], r[K]; \
+        batchLoadMat(a, A.mat, A.stride, K, b, n); \
+        batchLoadVec(r, y.x, y.stride, K, b, n); \
+        batchEliminate(K, a, r, 1); \
+        batchStore(x->x, x->stride, r, K, b, n); \
+    } \
+    return LINALG_OK; \
+} \
+void freeBlock##K##Batch(Block##K##Batch* batch) \
+{ \
+    if(!batch->mat) return; \
+    free(batch->mat); \
+    batch->mat = NULL; \
+    batch->count = 0; \
+} \
+void freeVec##K##Batch(Vec##K##Batch* batch) \
+{ \
+    if(!batch->x) return; \
+    free(batch->x); \
+    batch->x = NULL; \
+    batch->count = 0; \
+}
+
+LA_BLK_BATCH_DEFINE(2)
+LA_BLK_BATCH_DEFINE(3)
+LA_BLK_BATCH_DEFINE(4)
@@ -0,0 +1,446 @@
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+#include <float.h>
+
+// maximum QL sweeps per eigenvalue
+#define LA_EIG_QL_MAX_ITER 30
+// maximum inverse iteration steps per eigenvector(same as LAPACK dstein)
+#define LA_EIG_INV_MAX_ITER 5
+// eigenvalues closer than this(relative to ||A||) form a cluster, and their eigenvectors are reorthogonalized
+#define LA_EIG_CLUSTER_TOL 1e-3
+
+// shifts bisected together by triDiagSymEigenRange
+#define LA_EIG_LANES 8
+
+// A[i][i], A[i + 1][i] of the symmetric matrix(subdiagonal[i + 1])
+#define LA_EIG_D(A, i) (A).diagonal.x[(i) * (A).diagonal.offset]
+#define LA_EIG_E(A, i) (A).subdiagonal.x[((i) + 1) * (A).subdiagonal.offset]
+
+// max |A[i][j]| row sum(||A||_inf), and the gershgorin interval of the spectrum
+static double eigNorm(MatTriDiag A, double* lo, double* hi)
+{
+    size_t n = A.diagonal.len;
+    double norm = 0;
+    *lo = INFINITY;
+    *hi = -INFINITY;
+    for(size_t i = 0; i < n; i++)
+    {
+        double r = (i > 0 ? fabs(LA_EIG_E(A, i - 1)) : 0) + (i + 1 < n ? fabs(LA_EIG_E(A, i)) : 0);
+        double d = LA_EIG_D(A, i);
+        *lo = d - r < *lo ? d - r : *lo;
+        *hi = d + r > *hi ? d + r : *hi;
+        norm = fabs(d) + r > norm ? fabs(d) + r : norm;
+    }
+    return norm;
+}
+
+// smallest pivot allowed in the sturm sequence(LAPACK dstebz)
+static double eigPivmin(MatTriDiag A)
+{
+    double emax = 1;
+    for(size_t i = 0; i + 1 < A.diagonal.len; i++) emax = LA_EIG_E(A, i) * LA_EIG_E(A, i) > emax ? LA_EIG_E(A, i) * LA_EIG_E(A, i) : emax;
+    return DBL_MIN * emax;
+}
+
+// negative pivots of the LDL^T factorization of A - xI
+static size_t eigSturm(MatTriDiag A, double x, double pivmin)
+{
+    size_t n = A.diagonal.len;
+    size_t count = 0;
+    double q = LA_EIG_D(A, 0) - x;
+    if(fabs(q) < pivmin) q = -pivmin;
+    count += q < 0;
+
+    for(size_t i = 1; i < n; i++)
+    {
+        double e = LA_EIG_E(A, i - 1);
+        q = LA_EIG_D(A, i) - x - e * e / q;
+        if(fabs(q) < pivmin) q = -pivmin;
+        count += q < 0;
+    }
+    return count;
+}
+
+// sturm counts for LA_EIG_LANES shifts at once, the independent recurrences hide the division latency
+static void eigSturmLanes(MatTriDiag A, const double* x, double pivmin, size_t* count)
+{
+    size_t n = A.diagonal.len;
+    double q[LA_EIG_LANES], c[LA_EIG_LANES];
+
+    double d = LA_EIG_D(A, 0);
+    for(size_t l = 0; l < LA_EIG_LANES; l++)
+    {
+        q[l] = d - x[l];
+        q[l] = fabs(q[l]) < pivmin ? -pivmin : q[l];
+        c[l] = q[l] < 0;
+    }
+
+    for(size_t i = 1; i < n; i++)
+    {
+        double e = LA_EIG_E(A, i - 1);
+        double e2 = e * e;
+        d = LA_EIG_D(A, i);
+        for(size_t l = 0; l < LA_EIG_LANES; l++)
+        {
+            q[l] = d - x[l] - e2 / q[l];
+            q[l] = fabs(q[l]) < pivmin ? -pivmin : q[l];
+            c[l] += q[l] < 0;
+        }
+    }
+
+    for(size_t l = 0; l < LA_EIG_LANES; l++) count[l] = (size_t)c[l];
+}
+
+// sort eigenvalues ascending, swapping eigenvector rows along
+static void eigSort(double* d, size_t s, size_t n, Mat2d* vectors)
+{
+    for(size_t i = 0; i + 1 < n; i++)
+    {
+        size_t k = i;
+        for(size_t j = i + 1; j < n; j++) k = d[j * s] < d[k * s] ? j : k;
+        if(k == i) continue;
+
+        double tmp = d[i * s];
+        d[i * s] = d[k * s];
+        d[k * s] = tmp;
+
+        if(!vectors) continue;
+        double* vi = vectors->mat + i * vectors->cols;
+        double* vk = vectors->mat + k * vectors->cols;
+        for(size_t j = 0; j < n; j++)
+        {
+            tmp = vi[j];
+            vi[j] = vk[j];
+            vk[j] = tmp;
+        }
+    }
+}
+
+// all eigenvalues(and optionally eigenvectors) of symmetric tridiagonal A with implicit QL
+int triDiagSymEigen(MatTriDiag A, Vec* values, Mat2d* vectors)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, vectors != NULL, 0);
+    size_t n = A.diagonal.len;
+    LINALG_ASSERT_ERROR(!values || !values->x || !A.diagonal.x || !A.subdiagonal.x || !A.scratch.x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(values->len != n || A.subdiagonal.len < n || A.scratch.len < n, LINALG_ERROR,
+                        "invalid vector: eigenvalues of tridiagonal matrix(%zu) into vec(%zu)", n, values->len);
+    LINALG_ASSERT_ERROR(vectors && (!vectors->mat || vectors->rows != n || vectors->cols != n), LINALG_ERROR,
+                        "invalid operation: eigenvectors of tridiagonal matrix(%zu) into mat(%zux%zu)", n, vectors->rows, vectors->cols);
+
+    double* d = values->x;
+    size_t s = values->offset;
+    double* e = A.scratch.x;
+    size_t es = A.scratch.offset;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        d[i * s] = LA_EIG_D(A, i);
+        e[i * es] = i + 1 < n ? LA_EIG_E(A, i) : 0;
+    }
+
+    // eigenvectors are kept as rows, so every rotation touches two contiguous rows
+    if(vectors)
+    {
+        memset(vectors->mat, 0, n * n * sizeof(double));
+        for(size_t i = 0; i < n; i++) vectors->mat[i * n + i] = 1;
+    }
+
+    for(size_t l = 0; l < n; l++)
+    {
+        size_t iter = 0, m;
+        do
+        {
+            // look for a negligible off diagonal element to split the matrix
+            for(m = l; m + 1 < n; m++)
+            {
+                double dd = fabs(d[m * s]) + fabs(d[(m + 1) * s]);
+                if(fabs(e[m * es]) <= DBL_EPSILON * dd) break;
+            }
+            if(m == l) break;
+
+            LINALG_ASSERT_ERROR(iter++ == LA_EIG_QL_MAX_ITER, LINALG_ERROR, "QL iteration did not converge for eigenvalue %zu!", l);
+
+            // implicit wilkinson shift
+            double g = (d[(l + 1) * s] - d[l * s]) / (2.0 * e[l * es]);
+            double r = hypot(g, 1.0);
+            g = d[m * s] - d[l * s] + e[l * es] / (g + copysign(r, g));
+
+            double sn = 1, cs = 1, p = 0;
+            size_t i;
+            int deflated = 0;
+            for(i = m; i-- > l;)
+            {
+                double f = sn * e[i * es];
+                double b = cs * e[i * es];
+                r = hypot(f, g);
+                e[(i + 1) * es] = r;
+                if(r == 0)
+                {
+                    // underflow, deflate and start over
+                    d[(i + 1) * s] -= p;
+                    e[m * es] = 0;
+                    deflated = 1;
+                    break;
+                }
+                sn = f / r;
+                cs = g / r;
+                g = d[(i + 1) * s] - p;
+                r = (d[i * s] - g) * sn + 2.0 * cs * b;
+                p = sn * r;
+                d[(i + 1) * s] = g + p;
+                g = cs * r - b;
+
+                if(vectors)
+                {
+                    double* vi = vectors->mat + i * n;
+                    double* vi1 = vectors->mat + (i + 1) * n;
+                    for(size_t k = 0; k < n; k++)
+                    {
+                        double t = vi1[k];
+                        vi1[k] = sn * vi[k] + cs * t;
+                        vi[k] = cs * vi[k] - sn * t;
+                    }
+                }
+            }
+            if(deflated) continue;
+
+            d[l * s] -= p;
+            e[l * es] = g;
+            e[m * es] = 0;
+        } while(m != l);
+    }
+
+    eigSort(d, s, n, vectors);
+    return LINALG_OK;
+}
+
+// number of eigenvalues of symmetric tridiagonal A less than x(sturm count)
+size_t triDiagSymEigenCount(MatTriDiag A, double x)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, 0, 0);
+    LINALG_ASSERT_ERROR(!A.diagonal.x || !A.subdiagonal.x || A.diagonal.len == 0, 0, "input matrix is null!");
+    return eigSturm(A, x, eigPivmin(A));
+}
+
+// eigenvalues il to iu - 1(ascending, 0 based) of symmetric tridiagonal A with bisection
+int triDiagSymEigenRange(MatTriDiag A, size_t il, size_t iu, Vec* values)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, il, iu);
+    size_t n = A.diagonal.len;
+    LINALG_ASSERT_ERROR(!values || !values->x || !A.diagonal.x || !A.subdiagonal.x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(il >= iu || iu > n || values->len != iu - il, LINALG_ERROR,
+                        "invalid range: eigenvalues [%zu, %zu) of tridiagonal matrix(%zu) into vec(%zu)", il, iu, n, values->len);
+
+    double lo, hi;
+    double norm = eigNorm(A, &lo, &hi);
+    double pivmin = eigPivmin(A);
+
+    // widen the gershgorin interval a little so the end points surely bracket the spectrum
+    double pad = 2.0 * DBL_EPSILON * norm * (double)n + 2.0 * pivmin;
+    lo -= pad;
+    hi += pad;
+
+    // eigenvalues are bisected LA_EIG_LANES at a time, one sturm pass serves every lane
+    for(size_t jb = il; jb < iu; jb += LA_EIG_LANES)
+    {
+        size_t m = iu - jb < LA_EIG_LANES ? iu - jb : LA_EIG_LANES;
+        double a[LA_EIG_LANES], b[LA_EIG_LANES], mid[LA_EIG_LANES];
+        size_t count[LA_EIG_LANES];
+
+        // the lower end of the previous brackets still holds
+        for(size_t l = 0; l < LA_EIG_LANES; l++)
+        {
+            a[l] = lo;
+            b[l] = hi;
+        }
+
+        while(1)
+        {
+            int active = 0;
+            for(size_t l = 0; l < LA_EIG_LANES; l++)
+            {
+                mid[l] = 0.5 * (a[l] + b[l]);
+                int open = l < m && b[l] - a[l] > 2.0 * DBL_EPSILON * fmax(fabs(a[l]), fabs(b[l])) + pivmin && mid[l] > a[l] && mid[l] < b[l];
+                active |= open;
+            }
+            if(!active) break;
+
+            eigSturmLanes(A, mid, pivmin, count);
+
+            // eigenvalue j is the smallest x with count(x) > j, every count narrows every bracket it falls in
+            for(size_t l = 0; l < m; l++)
+            {
+                for(size_t t = 0; t < m; t++)
+                {
+                    if(mid[l] <= a[t] || mid[l] >= b[t]) continue;
+                    if(count[l] > jb + t) b[t] = mid[l];
+                    else a[t] = mid[l];
+                }
+            }
+        }
+
+        for(size_t l = 0; l < m; l++) values->x[(jb + l - il) * values->offset] = 0.5 * (a[l] + b[l]);
+        lo = a[m - 1];
+    }
+
+    return LINALG_OK;
+}
+
+// LU factorize A - lambda I with partial pivoting(LAPACK dlagtf), work rows: l, u0, u1, u2, pivot
+static void eigShiftedLU(MatTriDiag A, double lambda, double tiny, double* w, size_t ld)
+{
+    size_t n = A.diagonal.len;
+    double* l = w;
+    double* u0 = w + ld;
+    double* u1 = w + 2 * ld;
+    double* u2 = w + 3 * ld;
+    double* piv = w + 4 * ld;
+
+    double p = LA_EIG_D(A, 0) - lambda;
+    double q = n > 1 ? LA_EIG_E(A, 0) : 0;
+    for(size_t i = 0; i + 1 < n; i++)
+    {
+        double c = LA_EIG_E(A, i);
+        double a1 = LA_EIG_D(A, i + 1) - lambda;
+        double b1 = i + 2 < n ? LA_EIG_E(A, i + 1) : 0;
+
+        if(fabs(p) >= fabs(c))
+        {
+            if(p == 0) p = tiny;
+            l[i] = c / p;
+            u0[i] = p;
+            u1[i] = q;
+            u2[i] = 0;
+            piv[i] = 0;
+            p = a1 - l[i] * q;
+            q = b1;
+        }
+        else
+        {
+            l[i] = p / c;
+            u0[i] = c;
+            u1[i] = a1;
+            u2[i] = b1;
+            piv[i] = 1;
+            p = q - l[i] * a1;
+            q = -l[i] * b1;
+        }
+    }
+    u0[n - 1] = p == 0 ? tiny : p;
+}
+
+// solve (A - lambda I) x = x with the factorization from eigShiftedLU, zero pivots are perturbed to tiny
+static void eigShiftedSolve(size_t n, const double* w, size_t ld, double tiny, double* x)
+{
+    const double* l = w;
+    const double* u0 = w + ld;
+    const double* u1 = w + 2 * ld;
+    const double* u2 = w + 3 * ld;
+    const double* piv = w + 4 * ld;
+
+    for(size_t i = 0; i + 1 < n; i++)
+    {
+        if(piv[i] != 0)
+        {
+            double tmp = x[i];
+            x[i] = x[i + 1];
+            x[i + 1] = tmp;
+        }
+        x[i + 1] -= l[i] * x[i];
+    }
+
+    for(size_t i = n; i-- > 0;)
+    {
+        double sum = x[i];
+        if(i + 1 < n) sum -= u1[i] * x[i + 1];
+        if(i + 2 < n) sum -= u2[i] * x[i + 2];
+        x[i] = sum / (u0[i] == 0 ? tiny : u0[i]);
+    }
+}
+
+// eigenvectors of symmetric tridiagonal A for the given(ascending) eigenvalues with inverse iteration
+int triDiagSymEigenvectors(MatTriDiag A, Vec values, Mat2d* vectors, Mat2d* work)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, values.len, 0);
+    size_t n = A.diagonal.len, k = values.len;
+    LINALG_ASSERT_ERROR(!values.x || !vectors || !vectors->mat || !work || !work->mat || !A.diagonal.x || !A.subdiagonal.x, LINALG_ERROR, "input/output/scratch is null!");
+    LINALG_ASSERT_ERROR(vectors->rows != k || vectors->cols != n, LINALG_ERROR,
+                        "invalid operation: %zu eigenvectors of tridiagonal matrix(%zu) into mat(%zux%zu)", k, n, vectors->rows, vectors->cols);
+    LINALG_ASSERT_ERROR(work->rows * work->cols < 5 * n, LINALG_ERROR, "invalid scratch: needs 5 x %zu elements, got mat(%zux%zu)", n, work->rows, work->cols);
+
+    double lo, hi;
+    double norm = eigNorm(A, &lo, &hi);
+    double tiny = DBL_EPSILON * (norm > 0 ? norm : 1);
+    double cluster_tol = LA_EIG_CLUSTER_TOL * norm;
+    // a converged solve grows the unit start vector by at least 1 / (sqrt(n) * eps * ||A||)
+    double growth = 1.0 / (sqrt((double)n) * 8.0 * tiny);
+
+    size_t cluster = 0;
+    double prev = 0;
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+    for(size_t j = 0; j < k; j++)
+    {
+        double lambda = values.x[j * values.offset];
+        if(j > 0 && lambda - values.x[(j - 1) * values.offset] > cluster_tol) cluster = j;
+
+        // separate close eigenvalues, so the shifted factorizations differ(LAPACK dstein)
+        if(j > cluster && lambda - prev < 10.0 * tiny) lambda = prev + 10.0 * tiny;
+        prev = lambda;
+
+        eigShiftedLU(A, lambda, tiny, work->mat, n);
+
+        double* x = vectors->mat + j * n;
+        for(size_t i = 0; i < n; i++)
+        {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            x[i] = (double)(seed >> 11) / (double)(1ull << 53) - 0.5;
+        }
+
+        int converged = 0;
+        for(size_t iter = 0; iter < LA_EIG_INV_MAX_ITER && converged < 2; iter++)
+        {
+            double nrm = 0;
+            for(size_t i = 0; i < n; i++) nrm += x[i] * x[i];
+            nrm = sqrt(nrm);
+            for(size_t i = 0; i < n; i++) x[i] /= nrm;
+
+            eigShiftedSolve(n, work->mat, n, tiny, x);
+
+            // gram schmidt against the earlier vectors of the cluster
+            for(size_t c = cluster; c < j; c++)
+            {
+                const double* v = vectors->mat + c * n;
+                double dot = 0;
+                for(size_t i = 0; i < n; i++) dot += v[i] * x[i];
+                for(size_t i = 0; i < n; i++) x[i] -= dot * v[i];
+            }
+
+            nrm = 0;
+            for(size_t i = 0; i < n; i++) nrm += x[i] * x[i];
+            // one more step after convergence, to clean up the direction
+            if(sqrt(nrm) >= growth) converged++;
+        }
+
+        if(converged == 0)
+        {
+            LINALG_REPORT_WARN("inverse iteration did not converge for eigenvalue %zu(%le)!", j, lambda);
+        }
+
+        // unit length, largest component positive
+        double nrm = 0;
+        size_t imax = 0;
+        for(size_t i = 0; i < n; i++)
+        {
+            nrm += x[i] * x[i];
+            imax = fabs(x[i]) > fabs(x[imax]) ? i : imax;
+        }
+        nrm = copysign(sqrt(nrm), x[imax]);
+        for(size_t i = 0; i < n; i++) x[i] /= nrm;
+    }
+
+    return LINALG_OK;
+}
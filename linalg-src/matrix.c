@@ -4,6 +4,18 @@
 #include <memory.h>
 #include <math.h>
 
+#include <pthread.h>
+
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/mman.h>
+#define LA_MUL_MSYNC 1
+#endif
+
 // LINALG_UNPACK_MAT(matrix, r, c)[x][y] = value at xth col and yth row
 #define LA_UNPACK(matrix) ((double (*)[matrix.cols]) matrix.mat)
 
@@ -15,6 +27,7 @@
 // initialzie the matrix on the heap with some initial value
 Mat2d mat2DInitA(double value, size_t rows, size_t cols)
 {
+    LINALG_TRACE_SCOPE(rows, cols, 0);
     if(rows == 0 || cols == 0)
     {
         LINALG_REPORT_ERROR("invalid zero row or col matrix requested!");
@@ -22,7 +35,9 @@ Mat2d mat2DInitA(double value, size_t rows, size_t cols)
     }
     Mat2d mat = { (double*)calloc(rows*cols, sizeof(double)), rows, cols };
     LINALG_ASSERT_ERROR(!mat.mat, mat, "unkown error occured when allocation memory!");
-    for(size_t i = 0; i < mat.cols*mat.rows; i++) mat.mat[i] = value;
+    // calloc memory is already zero, filling it again would touch every page for nothing
+    if(value != 0.0 || signbit(value))
+        for(size_t i = 0; i < mat.cols*mat.rows; i++) mat.mat[i] = value;
 
     return mat;
 }
@@ -40,6 +55,7 @@ Mat2d mat2DInitOnesA(size_t rows, size_t cols)
 // make a copy of a matrix on heap
 Mat2d mat2DCopyA(Mat2d matrix)
 {
+    LINALG_TRACE_SCOPE(matrix.rows, matrix.cols, 0);
     if(matrix.rows == 0 || matrix.cols == 0)
     {
         LINALG_REPORT_ERROR("invalid zero row or col matrix requested!");
@@ -58,6 +74,7 @@ Mat2d mat2DCopyA(Mat2d matrix)
 // make a copy of a matrix on heap
 int mat2DCopy(Mat2d src, Mat2d* dst)
 {
+    LINALG_TRACE_SCOPE(src.rows, src.cols, 0);
     LINALG_ASSERT_ERROR(src.rows == 0 || src.cols == 0, LINALG_ERROR, "invalid zero row or col matrix requested!");
     LINALG_ASSERT_ERROR(!src.mat, LINALG_ERROR, "invalid zero row or col matrix requested!");
     LINALG_ASSERT_ERROR(src.cols == dst->cols && src.rows == dst->rows, LINALG_ERROR, "mat2DCopy arguments do not have same size!");
@@ -76,6 +93,7 @@ Mat2d mat2DConstruct(double* ptr, size_t rows, size_t cols)
 // pretty print a matrix
 void mat2DPrint(Mat2d a)
 {
+    LINALG_TRACE_SCOPE(a.rows, a.cols, 0);
     printf("[\n");
     for(size_t i = 0; i < a.rows; i++)
     {
@@ -128,6 +146,7 @@ double* mat2DRef(Mat2d a, size_t row, size_t col)
 // add 2 matrixs and get result into another matrix, prints error if input is invalid
 int mat2DAdd(Mat2d a, Mat2d b, Mat2d* result)
 {
+    LINALG_TRACE_SCOPE(a.rows, a.cols, 0);
     LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(a.rows != b.rows || b.cols != a.cols, LINALG_ERROR, "attempt to add mat(%zux%zu) and mat(%zux%zu)", a.cols, a.rows, b.cols, b.rows);
@@ -140,6 +159,7 @@ int mat2DAdd(Mat2d a, Mat2d b, Mat2d* result)
 // subtract 2 matrixes(a-b) and get result into another matrix, prints error if input is invalid
 int mat2DSub(Mat2d a, Mat2d b, Mat2d* result)
 {
+    LINALG_TRACE_SCOPE(a.rows, a.cols, 0);
     LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(a.rows != b.rows || b.cols != a.cols, LINALG_ERROR, "attempt to add mat(%zux%zu) and mat(%zux%zu)", a.cols, a.rows, b.cols, b.rows);
@@ -152,6 +172,7 @@ int mat2DSub(Mat2d a, Mat2d b, Mat2d* result)
 // multiply scalar value to matrixs and get result into another matrix, prints error if input is invalid
 int mat2DScale(double a, Mat2d b, Mat2d* result)
 {
+    LINALG_TRACE_SCOPE(b.rows, b.cols, 0);
     LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(b.rows != result->rows || b.cols != result->cols, LINALG_ERROR, "result matrix is mat(%zux%zu) but inputs are mat(%zux%zu)", result->cols, result->rows, b.cols, b.rows);
@@ -161,79 +182,260 @@ int mat2DScale(double a, Mat2d b, Mat2d* result)
     return LINALG_OK;
 }
 
-// compute result = Ax. prints error if the input is invalid
-int mat2DTransform(Mat2d A, Vec x, Vec* result)
+// y[i] = alpha * (Ax)[i] + beta * y[i] for the rows [row_begin, row_end)
+// 4 rows are processed together, so every x[j] loaded is used 4 times
+// if beta is zero, y is not read(so it may hold garbage)
+static void mat2DGemvRows(double alpha, Mat2d A, Vec x, double beta, Vec y, size_t row_begin, size_t row_end)
 {
-    LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
-    LINALG_ASSERT_ERROR(!result->x, LINALG_ERROR, "result matrix is null!");
+    const double* xp = x.x;
+    size_t xs = x.offset;
+    size_t n = A.cols;
+
+    size_t i = row_begin;
+    for(; i + 4 <= row_end; i += 4)
+    {
+        const double* a0 = A.mat + i * n;
+        const double* a1 = a0 + n;
+        const double* a2 = a1 + n;
+        const double* a3 = a2 + n;
+
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        if(xs == 1)
+        {
+            for(size_t j = 0; j < n; j++)
+            {
+                double xj = xp[j];
+                s0 += a0[j] * xj;
+                s1 += a1[j] * xj;
+                s2 += a2[j] * xj;
+                s3 += a3[j] * xj;
+            }
+        }
+        else
+        {
+            for(size_t j = 0; j < n; j++)
+            {
+                double xj = xp[j * xs];
+                s0 += a0[j] * xj;
+                s1 += a1[j] * xj;
+                s2 += a2[j] * xj;
+                s3 += a3[j] * xj;
+            }
+        }
+
+        double* yp = y.x + i * y.offset;
+        if(beta == 0)
+        {
+            yp[0] = alpha * s0;
+            yp[y.offset] = alpha * s1;
+            yp[2 * y.offset] = alpha * s2;
+            yp[3 * y.offset] = alpha * s3;
+        }
+        else
+        {
+            yp[0] = alpha * s0 + beta * yp[0];
+            yp[y.offset] = alpha * s1 + beta * yp[y.offset];
+            yp[2 * y.offset] = alpha * s2 + beta * yp[2 * y.offset];
+            yp[3 * y.offset] = alpha * s3 + beta * yp[3 * y.offset];
+        }
+    }
+    for(; i < row_end; i++)
+    {
+        const double* a = A.mat + i * n;
+        double sum = 0;
+        for(size_t j = 0; j < n; j++) sum += a[j] * xp[j * xs];
+
+        double* yp = y.x + i * y.offset;
+        *yp = beta == 0 ? alpha * sum : alpha * sum + beta * *yp;
+    }
+}
+
+// y[j] += alpha * sum_i x[i] * A[i][j] for the rows i in [row_begin, row_end), y has stride ys
+// A is read row-wise, 4 rows at a time, so y is streamed once per 4 rows of A
+static void mat2DGemvTRows(double alpha, Mat2d A, Vec x, double* y, size_t ys, size_t row_begin, size_t row_end)
+{
+    size_t n = A.cols;
+
+    size_t i = row_begin;
+    for(; i + 4 <= row_end; i += 4)
+    {
+        const double* a0 = A.mat + i * n;
+        const double* a1 = a0 + n;
+        const double* a2 = a1 + n;
+        const double* a3 = a2 + n;
+
+        double c0 = alpha * x.x[i * x.offset];
+        double c1 = alpha * x.x[(i + 1) * x.offset];
+        double c2 = alpha * x.x[(i + 2) * x.offset];
+        double c3 = alpha * x.x[(i + 3) * x.offset];
+
+        if(ys == 1)
+        {
+            for(size_t j = 0; j < n; j++) y[j] += c0 * a0[j] + c1 * a1[j] + c2 * a2[j] + c3 * a3[j];
+        }
+        else
+        {
+            for(size_t j = 0; j < n; j++) y[j * ys] += c0 * a0[j] + c1 * a1[j] + c2 * a2[j] + c3 * a3[j];
+        }
+    }
+    for(; i < row_end; i++)
+    {
+        const double* a = A.mat + i * n;
+        double c = alpha * x.x[i * x.offset];
+        for(size_t j = 0; j < n; j++) y[j * ys] += c * a[j];
+    }
+}
+
+// compute y = alpha * Ax + beta * y. prints error if the input is invalid
+// if beta is zero, y is only written to
+int mat2DGemv(double alpha, Mat2d A, Vec x, double beta, Vec* y)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
+    LINALG_ASSERT_ERROR(!y, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(!y->x, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(!A.mat || !x.x, LINALG_ERROR, "input matrix/vector is null!");
+    LINALG_ASSERT_ERROR(x.x == y->x, LINALG_ERROR, "result vector can not alias the input!");
     LINALG_ASSERT_ERROR(A.cols != x.len, LINALG_ERROR, "invalid vector: mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x.len);
-    LINALG_ASSERT_ERROR(A.rows != result->len, LINALG_ERROR, "invalid vector: mat(%zux%zu) applied over vec(%zu) is put in vec(%zu)", A.rows, A.cols, x.len, result->len);
+    LINALG_ASSERT_ERROR(A.rows != y->len, LINALG_ERROR, "invalid vector: mat(%zux%zu) applied over vec(%zu) is put in vec(%zu)", A.rows, A.cols, x.len, y->len);
 
-    for(size_t i = 0; i < A.rows; i++)
+    mat2DGemvRows(alpha, A, x, beta, *y, 0, A.rows);
+
+    return LINALG_OK;
+}
+// compute y = alpha * A^T x + beta * y, without forming A^T. prints error if the input is invalid
+// if beta is zero, y is only written to
+int mat2DGemvT(double alpha, Mat2d A, Vec x, double beta, Vec* y)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
+    LINALG_ASSERT_ERROR(!y, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(!y->x, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(!A.mat || !x.x, LINALG_ERROR, "input matrix/vector is null!");
+    LINALG_ASSERT_ERROR(x.x == y->x, LINALG_ERROR, "result vector can not alias the input!");
+    LINALG_ASSERT_ERROR(A.rows != x.len, LINALG_ERROR, "invalid vector: transpose of mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x.len);
+    LINALG_ASSERT_ERROR(A.cols != y->len, LINALG_ERROR, "invalid vector: transpose of mat(%zux%zu) applied over vec(%zu) is put in vec(%zu)", A.rows, A.cols, x.len, y->len);
+
+    for(size_t j = 0; j < y->len; j++)
     {
-        double val = 0;
-        for(size_t j = 0; j < A.cols; j++) val += LA_UNPACK(A)[i][j] * VEC_INDEX(x, j);
-        VEC_INDEX(*result, i) = val;
+        double* yj = y->x + j * y->offset;
+        *yj = beta == 0 ? 0 : beta * *yj;
     }
 
+    mat2DGemvTRows(alpha, A, x, y->x, y->offset, 0, A.rows);
+
     return LINALG_OK;
 }
+
+// compute result = Ax. prints error if the input is invalid
+int mat2DTransform(Mat2d A, Vec x, Vec* result)
+{
+    return mat2DGemv(1.0, A, x, 0.0, result);
+}
 // compute result = Ax. prints error if the input is invalid(allocates memory)
 Vec mat2DTransformA(Mat2d A, Vec x)
 {
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
     Vec badVec = {NULL, 0, 0};
     LINALG_ASSERT_ERROR(A.cols != x.len, badVec, "invalid vector: mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x.len);
 
     Vec result = vecInitZerosA(A.rows);
+    if(mat2DTransform(A, x, &result) != LINALG_OK) freeVec(&result);
 
-    for(size_t i = 0; i < A.rows; i++)
-    {
-        double val = 0;
-        for(size_t j = 0; j < A.cols; j++) val += LA_UNPACK(A)[i][j] * VEC_INDEX(x, j);
-        VEC_INDEX(result, i) = val;
-    }
+    return result;
+}
+// compute result = A^T x, without forming A^T. prints error if the input is invalid
+int mat2DTransformT(Mat2d A, Vec x, Vec* result)
+{
+    return mat2DGemvT(1.0, A, x, 0.0, result);
+}
+// compute result = A^T x(allocates result Vec), without forming A^T. prints error if the input is invalid
+Vec mat2DTransformTA(Mat2d A, Vec x)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
+    Vec badVec = {NULL, 0, 0};
+    LINALG_ASSERT_ERROR(A.rows != x.len, badVec, "invalid vector: transpose of mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x.len);
+
+    Vec result = vecInitZerosA(A.cols);
+    if(mat2DTransformT(A, x, &result) != LINALG_OK) freeVec(&result);
 
     return result;
 }
 
-// compute result = A*B. prints error if the input is invalid
-int mat2DMul(Mat2d A, Mat2d B, Mat2d* result)
+// columns of A(rows of B) and columns of B per block of mat2DMulBlock, the B block stays in L2
+#define LA_MUL_BLOCK_K 128
+#define LA_MUL_BLOCK_J 256
+
+// c0..c3 += a0..a3 * b over len elements, one load of b feeds 4 rows of the result
+static void mat2DMulKernel4(const double* restrict b, double a0, double a1, double a2, double a3,
+                            double* restrict c0, double* restrict c1, double* restrict c2, double* restrict c3, size_t len)
 {
-    LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
-    LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
-    LINALG_ASSERT_ERROR(A.cols != B.rows, LINALG_ERROR, "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols);
-    LINALG_ASSERT_ERROR(A.rows != result->rows || B.cols != result->cols, LINALG_ERROR, 
-                        "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu) stored in mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols, result->rows, result->cols);
+    for(size_t j = 0; j < len; j++)
+    {
+        double bj = b[j];
+        c0[j] += a0 * bj;
+        c1[j] += a1 * bj;
+        c2[j] += a2 * bj;
+        c3[j] += a3 * bj;
+    }
+}
 
-    for(size_t i = 0; i < A.rows; i++)
+// C = A*B(or C += A*B if accumulate) for row major blocks with leading dimensions lda/ldb/ldc, A is rowsxm and B is mxn
+// blocked over k and j, every row of C is built by contiguous axpys over rows of B
+static void mat2DMulBlock(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t rows, size_t m, size_t n, int accumulate)
+{
+    if(!accumulate) for(size_t i = 0; i < rows; i++) memset(c + i * ldc, 0, n * sizeof(double));
+
+    for(size_t jb = 0; jb < n; jb += LA_MUL_BLOCK_J)
     {
-        for(size_t j = 0; j < B.cols; j++)
+        size_t jlen = jb + LA_MUL_BLOCK_J < n ? LA_MUL_BLOCK_J : n - jb;
+        for(size_t kb = 0; kb < m; kb += LA_MUL_BLOCK_K)
         {
-            double res = 0;
-            for(size_t k = 0; k < B.rows; k++) res += LA_UNPACK(A)[i][k] * LA_UNPACK(B)[k][j];
-            LA_UNPACK_PTR(result)[i][j] = res;
+            size_t ke = kb + LA_MUL_BLOCK_K < m ? kb + LA_MUL_BLOCK_K : m;
+
+            size_t i = 0;
+            for(; i + 4 <= rows; i += 4)
+            {
+                double* ci = c + i * ldc + jb;
+                const double* ai = a + i * lda;
+                for(size_t k = kb; k < ke; k++)
+                {
+                    mat2DMulKernel4(b + k * ldb + jb, ai[k], ai[lda + k], ai[2 * lda + k], ai[3 * lda + k],
+                                    ci, ci + ldc, ci + 2 * ldc, ci + 3 * ldc, jlen);
+                }
+            }
+            for(; i < rows; i++)
+            {
+                double* ci = c + i * ldc + jb;
+                for(size_t k = kb; k < ke; k++)
+                {
+                    double aik = a[i * lda + k];
+                    const double* bk = b + k * ldb + jb;
+                    for(size_t j = 0; j < jlen; j++) ci[j] += aik * bk[j];
+                }
+            }
         }
     }
+}
 
-    return LINALG_OK;
+// result = A*B for the rows [row_begin, row_end) of result
+static void mat2DMulRows(Mat2d A, Mat2d B, Mat2d* result, size_t row_begin, size_t row_end)
+{
+    mat2DMulBlock(A.mat + row_begin * A.cols, A.cols, B.mat, B.cols, result->mat + row_begin * B.cols, B.cols, row_end - row_begin, A.cols, B.cols, 0);
+}
+
+// compute result = A*B. prints error if the input is invalid
+int mat2DMul(Mat2d A, Mat2d B, Mat2d* result)
+{
+    return mat2DMulCtx(NULL, A, B, result);
 }
 // compute result = A*B(allocates memory). prints error if the input is invalid
 Mat2d mat2DMulA(Mat2d A, Mat2d B)
 {
+    LINALG_TRACE_SCOPE(A.rows, A.cols, B.cols);
     Mat2d bad_mat = {NULL, 0, 0};
     LINALG_ASSERT_ERROR(A.cols != B.rows, bad_mat, "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols);
 
     Mat2d result = mat2DInitZerosA(A.rows, B.cols);
-
-    for(size_t i = 0; i < A.rows; i++)
-    {
-        for(size_t j = 0; j < B.cols; j++)
-        {
-            double res = 0;
-            for(size_t k = 0; k < B.rows; k++) res += LA_UNPACK(A)[i][k] * LA_UNPACK(B)[k][j];
-            LA_UNPACK(result)[i][j] = res;
-        }
-    }
+    if(result.mat) mat2DMulRows(A, B, &result, 0, A.rows);
 
     return result;
 }
@@ -242,6 +444,7 @@ Mat2d mat2DMulA(Mat2d A, Mat2d B)
 // scratch space should be nx(n+1) big and order should be n elements big
 int mat2DSqSolve(Mat2d A, Vec x, Mat2d* scratch, size_t* order, Vec* y)
 {
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
     LINALG_ASSERT_ERROR(A.rows != A.cols, LINALG_ERROR, "invalid operation: mat2DSq operation on non square matrix mat(%zux%zu)", A.rows, A.cols);
     LINALG_ASSERT_ERROR(scratch->rows + 1 != scratch->cols, LINALG_ERROR, "invalid operation: mat2DSq operation wrong scratch space mat(%zux%zu)", scratch->rows, scratch->cols);
 
@@ -312,27 +515,715 @@ int mat2DSqSolve(Mat2d A, Vec x, Mat2d* scratch, size_t* order, Vec* y)
     }
 }
 
+// tile edge of the blocked transpose, a source and destination tile together fit in L1
+#define LA_TRANSPOSE_TILE 32
+
+// transpose the 4x4 block at src(row stride src_stride) into dst(row stride dst_stride)
+// the block is transposed in registers when SSE2/AVX is available
+static inline void mat2DTranspose4x4(const double* src, size_t src_stride, double* dst, size_t dst_stride)
+{
+#if defined(__AVX__)
+    __m256d r0 = _mm256_loadu_pd(src);
+    __m256d r1 = _mm256_loadu_pd(src + src_stride);
+    __m256d r2 = _mm256_loadu_pd(src + 2 * src_stride);
+    __m256d r3 = _mm256_loadu_pd(src + 3 * src_stride);
+
+    // t0 = {r0[0], r1[0], r0[2], r1[2]}, t1 = {r0[1], r1[1], r0[3], r1[3]} and so on
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+    _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(dst + dst_stride, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(dst + 2 * dst_stride, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(dst + 3 * dst_stride, _mm256_permute2f128_pd(t1, t3, 0x31));
+#elif defined(__SSE2__)
+    // transpose as four 2x2 blocks
+    for(size_t i = 0; i < 4; i += 2)
+    {
+        for(size_t j = 0; j < 4; j += 2)
+        {
+            __m128d a = _mm_loadu_pd(src + i * src_stride + j);
+            __m128d b = _mm_loadu_pd(src + (i + 1) * src_stride + j);
+            _mm_storeu_pd(dst + j * dst_stride + i, _mm_unpacklo_pd(a, b));
+            _mm_storeu_pd(dst + (j + 1) * dst_stride + i, _mm_unpackhi_pd(a, b));
+        }
+    }
+#else
+    for(size_t i = 0; i < 4; i++)
+    {
+        for(size_t j = 0; j < 4; j++) dst[j * dst_stride + i] = src[i * src_stride + j];
+    }
+#endif
+}
+
+// transpose the rows [row_begin, row_end) of A into result, tile by tile
+// so both the reads and the strided writes stay inside a few pages
+static void mat2DTransposeRows(Mat2d A, Mat2d* result, size_t row_begin, size_t row_end)
+{
+    double* dst = result->mat;
+    size_t n = result->cols;
+
+    for(size_t ib = row_begin; ib < row_end; ib += LA_TRANSPOSE_TILE)
+    {
+        size_t ie = ib + LA_TRANSPOSE_TILE < row_end ? ib + LA_TRANSPOSE_TILE : row_end;
+        for(size_t jb = 0; jb < A.cols; jb += LA_TRANSPOSE_TILE)
+        {
+            size_t je = jb + LA_TRANSPOSE_TILE < A.cols ? jb + LA_TRANSPOSE_TILE : A.cols;
+
+            size_t i = ib;
+            for(; i + 4 <= ie; i += 4)
+            {
+                size_t j = jb;
+                for(; j + 4 <= je; j += 4) mat2DTranspose4x4(&LA_UNPACK(A)[i][j], A.cols, dst + j * n + i, n);
+                for(; j < je; j++)
+                {
+                    for(size_t k = i; k < i + 4; k++) dst[j * n + k] = LA_UNPACK(A)[k][j];
+                }
+            }
+            for(; i < ie; i++)
+            {
+                for(size_t j = jb; j < je; j++) dst[j * n + i] = LA_UNPACK(A)[i][j];
+            }
+        }
+    }
+}
+
+// in place transpose of the row tiles [tile_begin, tile_end) of a square matrix
+// each tile on or right of the diagonal is swapped with its mirror
+static void mat2DTransposeSelfTiles(Mat2d A, size_t tile_begin, size_t tile_end)
+{
+    size_t n = A.rows;
+    double* a = A.mat;
+
+    for(size_t bi = tile_begin; bi < tile_end; bi++)
+    {
+        size_t ib = bi * LA_TRANSPOSE_TILE;
+        size_t ie = ib + LA_TRANSPOSE_TILE < n ? ib + LA_TRANSPOSE_TILE : n;
+
+        // diagonal tile
+        for(size_t i = ib; i < ie; i++)
+        {
+            for(size_t j = i + 1; j < ie; j++)
+            {
+                double tmp = a[i * n + j];
+                a[i * n + j] = a[j * n + i];
+                a[j * n + i] = tmp;
+            }
+        }
+
+        // off diagonal tiles, (ib, jb) <-> (jb, ib)
+        for(size_t jb = ie; jb < n; jb += LA_TRANSPOSE_TILE)
+        {
+            size_t je = jb + LA_TRANSPOSE_TILE < n ? jb + LA_TRANSPOSE_TILE : n;
+
+            size_t i = ib;
+            for(; i + 4 <= ie; i += 4)
+            {
+                size_t j = jb;
+                for(; j + 4 <= je; j += 4)
+                {
+                    double tmp[16];
+                    mat2DTranspose4x4(a + i * n + j, n, tmp, 4);
+                    mat2DTranspose4x4(a + j * n + i, n, a + i * n + j, n);
+                    for(size_t k = 0; k < 4; k++) memcpy(a + (j + k) * n + i, tmp + 4 * k, 4 * sizeof(double));
+                }
+                for(; j < je; j++)
+                {
+                    for(size_t k = i; k < i + 4; k++)
+                    {
+                        double tmp = a[k * n + j];
+                        a[k * n + j] = a[j * n + k];
+                        a[j * n + k] = tmp;
+                    }
+                }
+            }
+            for(; i < ie; i++)
+            {
+                for(size_t j = jb; j < je; j++)
+                {
+                    double tmp = a[i * n + j];
+                    a[i * n + j] = a[j * n + i];
+                    a[j * n + i] = tmp;
+                }
+            }
+        }
+    }
+}
+
 // compute result = A^T. prints error if the input is invalid
 int mat2DTranspose(Mat2d A, Mat2d* result)
 {
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
     LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
     LINALG_ASSERT_ERROR(A.cols != result->rows || A.rows != result->cols, LINALG_ERROR, "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu)", A.rows, A.cols, result->rows, result->cols);
 
-    for(size_t i = 0; i < A.rows; i++)
+    // transposing onto itself
+    if(A.mat == result->mat) return mat2DTransposeSelf(result);
+
+    mat2DTransposeRows(A, result, 0, A.rows);
+
+    return LINALG_OK;
+}
+// compute A = A^T in place, A must be square. prints error if the input is invalid
+int mat2DTransposeSelf(Mat2d* A)
+{
+    LINALG_TRACE_SCOPE(A ? A->rows : 0, A ? A->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!A || !A->mat, LINALG_ERROR, "input matrix is null!");
+    LINALG_ASSERT_ERROR(A->rows != A->cols, LINALG_ERROR, "invalid operation: in place transpose of non square matrix mat(%zux%zu)", A->rows, A->cols);
+
+    mat2DTransposeSelfTiles(*A, 0, (A->rows + LA_TRANSPOSE_TILE - 1) / LA_TRANSPOSE_TILE);
+
+    return LINALG_OK;
+}
+
+// Threaded kernels, each splits its row(or tile) range helper over the threads of ctx
+
+typedef struct Mat2DGemvArgs
+{
+    double alpha;
+    Mat2d A;
+    Vec x;
+    double beta;
+    Vec* y;
+    // per thread partial results of mat2DGemvTCtx
+    double** partial;
+    size_t threads;
+} Mat2DGemvArgs;
+
+static void mat2DGemvTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    Mat2DGemvArgs* args = data;
+    (void)thread;
+    mat2DGemvRows(args->alpha, args->A, args->x, args->beta, *args->y, begin, end);
+}
+// compute y = alpha * Ax + beta * y on the threads of ctx(y is not read if beta is zero). prints error if the input is invalid
+int mat2DGemvCtx(LinalgCtx* ctx, double alpha, Mat2d A, Vec x, double beta, Vec* y)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, linalgCtxThreads(ctx));
+    if(LINALG_CTX_SERIAL(ctx, A.rows * A.cols)) return mat2DGemv(alpha, A, x, beta, y);
+
+    LINALG_ASSERT_ERROR(!y || !y->x, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(!A.mat || !x.x, LINALG_ERROR, "input matrix/vector is null!");
+    LINALG_ASSERT_ERROR(x.x == y->x, LINALG_ERROR, "result vector can not alias the input!");
+    LINALG_ASSERT_ERROR(A.cols != x.len, LINALG_ERROR, "invalid vector: mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x.len);
+    LINALG_ASSERT_ERROR(A.rows != y->len, LINALG_ERROR, "invalid vector: mat(%zux%zu) applied over vec(%zu) is put in vec(%zu)", A.rows, A.cols, x.len, y->len);
+
+    // grain is a multiple of 4, so only the last chunk misses the 4 row kernel
+    Mat2DGemvArgs args = { alpha, A, x, beta, y, NULL, 0 };
+    size_t grain = (LINALG_CTX_GRAIN(A.cols) + 3) & ~(size_t)3;
+    linalgParallelFor(ctx, 0, A.rows, grain, mat2DGemvTask, &args);
+
+    return LINALG_OK;
+}
+
+static void mat2DGemvTPartialTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    Mat2DGemvArgs* args = data;
+    mat2DGemvTRows(args->alpha, args->A, args->x, args->partial[thread], 1, begin, end);
+}
+// y[j] = beta * y[j] + sum of the partials
+static void mat2DGemvTReduceTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    Mat2DGemvArgs* args = data;
+    (void)thread;
+    for(size_t j = begin; j < end; j++)
+    {
+        double sum = 0;
+        for(size_t t = 0; t < args->threads; t++) sum += args->partial[t][j];
+
+        double* yj = args->y->x + j * args->y->offset;
+        *yj = args->beta == 0 ? sum : sum + args->beta * *yj;
+    }
+}
+static void mat2DGemvTZeroTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    Mat2DGemvArgs* args = data;
+    (void)thread;
+    for(size_t t = begin; t < end; t++) memset(args->partial[t], 0, args->A.cols * sizeof(double));
+}
+// compute y = alpha * A^T x + beta * y on the threads of ctx(y is not read if beta is zero). prints error if the input is invalid
+// every thread accumulates its rows of A into a partial y in its scratch, the partials are summed at the end
+int mat2DGemvTCtx(LinalgCtx* ctx, double alpha, Mat2d A, Vec x, double beta, Vec* y)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, linalgCtxThreads(ctx));
+    if(LINALG_CTX_SERIAL(ctx, A.rows * A.cols)) return mat2DGemvT(alpha, A, x, beta, y);
+
+    LINALG_ASSERT_ERROR(!y || !y->x, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(!A.mat || !x.x, LINALG_ERROR, "input matrix/vector is null!");
+    LINALG_ASSERT_ERROR(x.x == y->x, LINALG_ERROR, "result vector can not alias the input!");
+    LINALG_ASSERT_ERROR(A.rows != x.len, LINALG_ERROR, "invalid vector: transpose of mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x.len);
+    LINALG_ASSERT_ERROR(A.cols != y->len, LINALG_ERROR, "invalid vector: transpose of mat(%zux%zu) applied over vec(%zu) is put in vec(%zu)", A.rows, A.cols, x.len, y->len);
+
+    size_t threads = linalgCtxThreads(ctx);
+    double* partial[threads];
+    for(size_t t = 0; t < threads; t++)
+    {
+        partial[t] = linalgCtxScratch(ctx, t, A.cols * sizeof(double));
+        LINALG_ASSERT_ERROR(!partial[t], LINALG_ERROR, "could not get scratch for thread %zu!", t);
+    }
+
+    Mat2DGemvArgs args = { alpha, A, x, beta, y, partial, threads };
+    size_t grain = (LINALG_CTX_GRAIN(A.cols) + 3) & ~(size_t)3;
+
+    // partials are zeroed by whichever thread picks them up, first touch keeps them near that thread
+    linalgParallelFor(ctx, 0, threads, 1, mat2DGemvTZeroTask, &args);
+    linalgParallelFor(ctx, 0, A.rows, grain, mat2DGemvTPartialTask, &args);
+    linalgParallelFor(ctx, 0, A.cols, LINALG_CTX_GRAIN(threads), mat2DGemvTReduceTask, &args);
+
+    return LINALG_OK;
+}
+
+// compute result = Ax on the threads of ctx. prints error if the input is invalid
+int mat2DTransformCtx(LinalgCtx* ctx, Mat2d A, Vec x, Vec* result)
+{
+    return mat2DGemvCtx(ctx, 1.0, A, x, 0.0, result);
+}
+// compute result = A^T x on the threads of ctx, without forming A^T. prints error if the input is invalid
+int mat2DTransformTCtx(LinalgCtx* ctx, Mat2d A, Vec x, Vec* result)
+{
+    return mat2DGemvTCtx(ctx, 1.0, A, x, 0.0, result);
+}
+
+typedef struct Mat2DMulArgs
+{
+    const double* a;
+    size_t lda;
+    const double* b;
+    size_t ldb;
+    double* c;
+    size_t ldc;
+    size_t m;
+    size_t n;
+    int accumulate;
+} Mat2DMulArgs;
+
+static void mat2DMulTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    Mat2DMulArgs* args = data;
+    (void)thread;
+    mat2DMulBlock(args->a + begin * args->lda, args->lda, args->b, args->ldb, args->c + begin * args->ldc, args->ldc, end - begin, args->m, args->n, args->accumulate);
+}
+
+// mat2DMulBlock split over the rows of C on the threads of ctx
+static void mat2DMulBlockCtx(LinalgCtx* ctx, const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t rows, size_t m, size_t n, int accumulate)
+{
+    if(LINALG_CTX_SERIAL(ctx, rows * m * n))
+    {
+        mat2DMulBlock(a, lda, b, ldb, c, ldc, rows, m, n, accumulate);
+        return;
+    }
+
+    Mat2DMulArgs args = { a, lda, b, ldb, c, ldc, m, n, accumulate };
+    size_t grain = (LINALG_CTX_GRAIN(m * n) + 3) & ~(size_t)3;
+    linalgParallelFor(ctx, 0, rows, grain, mat2DMulTask, &args);
+}
+
+// compute result = A*B on the threads of ctx. prints error if the input is invalid
+int mat2DMulCtx(LinalgCtx* ctx, Mat2d A, Mat2d B, Mat2d* result)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, B.cols);
+    LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(A.cols != B.rows, LINALG_ERROR, "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols);
+    LINALG_ASSERT_ERROR(A.rows != result->rows || B.cols != result->cols, LINALG_ERROR,
+                        "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu) stored in mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols, result->rows, result->cols);
+
+    mat2DMulBlockCtx(ctx, A.mat, A.cols, B.mat, B.cols, result->mat, result->cols, A.rows, A.cols, B.cols, 0);
+    return LINALG_OK;
+}
+
+// dst = a + sign * b over rowsxcols blocks
+static void strassenAdd(double* dst, size_t ldd, const double* a, size_t lda, const double* b, size_t ldb, double sign, size_t rows, size_t cols)
+{
+    for(size_t i = 0; i < rows; i++)
+    {
+        double* d = dst + i * ldd;
+        const double* ai = a + i * lda;
+        const double* bi = b + i * ldb;
+        if(sign > 0.0)
+            for(size_t j = 0; j < cols; j++) d[j] = ai[j] + bi[j];
+        else
+            for(size_t j = 0; j < cols; j++) d[j] = ai[j] - bi[j];
+    }
+}
+
+static int strassenBase(size_t m, size_t k, size_t n, size_t cutoff)
+{
+    return m <= cutoff || k <= cutoff || n <= cutoff;
+}
+
+// C(mxn) = A(mxk)*B(kxn), Winograd's variant(7 products, 15 additions) on the even part and peeling for odd sizes
+// the schedule of Douglas et al.(GEMMW) needs two temporaries per level: X(m/2 x max(k/2, n/2)) and Y(k/2 x n/2)
+static void strassenRec(LinalgCtx* ctx, const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc,
+                        size_t m, size_t k, size_t n, size_t cutoff, double* work)
+{
+    if(strassenBase(m, k, n, cutoff))
+    {
+        mat2DMulBlockCtx(ctx, a, lda, b, ldb, c, ldc, m, k, n, 0);
+        return;
+    }
+
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    size_t ldx = k2 > n2 ? k2 : n2, ldy = n2;
+    double* x = work;
+    double* y = x + m2 * ldx;
+    double* next = y + k2 * ldy;
+
+    const double *a11 = a, *a12 = a + k2, *a21 = a + m2 * lda, *a22 = a21 + k2;
+    const double *b11 = b, *b12 = b + n2, *b21 = b + k2 * ldb, *b22 = b21 + n2;
+    double *c11 = c, *c12 = c + n2, *c21 = c + m2 * ldc, *c22 = c21 + n2;
+
+    // C21 = P7 = (A11 - A21)(B22 - B12)
+    strassenAdd(x, ldx, a11, lda, a21, lda, -1.0, m2, k2);
+    strassenAdd(y, ldy, b22, ldb, b12, ldb, -1.0, k2, n2);
+    strassenRec(ctx, x, ldx, y, ldy, c21, ldc, m2, k2, n2, cutoff, next);
+    // C22 = P5 = (A21 + A22)(B12 - B11)
+    strassenAdd(x, ldx, a21, lda, a22, lda, 1.0, m2, k2);
+    strassenAdd(y, ldy, b12, ldb, b11, ldb, -1.0, k2, n2);
+    strassenRec(ctx, x, ldx, y, ldy, c22, ldc, m2, k2, n2, cutoff, next);
+    // C12 = P6 = (A21 + A22 - A11)(B22 - B12 + B11)
+    strassenAdd(x, ldx, x, ldx, a11, lda, -1.0, m2, k2);
+    strassenAdd(y, ldy, b22, ldb, y, ldy, -1.0, k2, n2);
+    strassenRec(ctx, x, ldx, y, ldy, c12, ldc, m2, k2, n2, cutoff, next);
+    // C11 = P3 = (A12 - S2)B22
+    strassenAdd(x, ldx, a12, lda, x, ldx, -1.0, m2, k2);
+    strassenRec(ctx, x, ldx, b22, ldb, c11, ldc, m2, k2, n2, cutoff, next);
+    // X = P1 = A11 B11
+    strassenRec(ctx, a11, lda, b11, ldb, x, ldx, m2, k2, n2, cutoff, next);
+
+    // U2 = P1 + P6, U3 = U2 + P7, U4 = U2 + P5, U7 = U3 + P5, U5 = U4 + P3
+    strassenAdd(c12, ldc, x, ldx, c12, ldc, 1.0, m2, n2);
+    strassenAdd(c21, ldc, c12, ldc, c21, ldc, 1.0, m2, n2);
+    strassenAdd(c12, ldc, c12, ldc, c22, ldc, 1.0, m2, n2);
+    strassenAdd(c22, ldc, c21, ldc, c22, ldc, 1.0, m2, n2);
+    strassenAdd(c12, ldc, c12, ldc, c11, ldc, 1.0, m2, n2);
+
+    // C21 = U6 = U3 - A22(T2 - B21)
+    strassenAdd(y, ldy, y, ldy, b21, ldb, -1.0, k2, n2);
+    strassenRec(ctx, a22, lda, y, ldy, c11, ldc, m2, k2, n2, cutoff, next);
+    strassenAdd(c21, ldc, c21, ldc, c11, ldc, -1.0, m2, n2);
+    // C11 = U1 = P1 + A12 B21
+    strassenRec(ctx, a12, lda, b21, ldb, c11, ldc, m2, k2, n2, cutoff, next);
+    strassenAdd(c11, ldc, c11, ldc, x, ldx, 1.0, m2, n2);
+
+    // peel the odd row/column/inner index
+    size_t me = 2 * m2, ke = 2 * k2, ne = 2 * n2;
+    if(ke < k)
+    {
+        for(size_t i = 0; i < me; i++)
+        {
+            double aik = a[i * lda + ke];
+            const double* bk = b + ke * ldb;
+            double* ci = c + i * ldc;
+            for(size_t j = 0; j < ne; j++) ci[j] += aik * bk[j];
+        }
+    }
+    if(ne < n) mat2DMulBlock(a, lda, b + ne, ldb, c + ne, ldc, me, k, 1, 0);
+    if(me < m) mat2DMulBlock(a + me * lda, lda, b, ldb, c + me * ldc, ldc, 1, k, n, 0);
+}
+
+// elements of work needed by mat2DMulStrassen for a (mxk)*(kxn) product
+size_t mat2DMulStrassenWorkSize(size_t m, size_t k, size_t n, size_t cutoff)
+{
+    if(cutoff == 0) cutoff = LINALG_STRASSEN_CUTOFF;
+
+    size_t size = 0;
+    while(!strassenBase(m, k, n, cutoff))
+    {
+        m /= 2, k /= 2, n /= 2;
+        size += m * (k > n ? k : n) + k * n;
+    }
+    return size;
+}
+
+// compute result = A*B with Strassen-Winograd recursion down to cutoff. prints error if the input is invalid
+int mat2DMulStrassen(Mat2d A, Mat2d B, Mat2d* result, size_t cutoff, Mat2d* work)
+{
+    return mat2DMulStrassenCtx(NULL, A, B, result, cutoff, work);
+}
+// compute result = A*B with Strassen-Winograd recursion, the classical products run on the threads of ctx
+int mat2DMulStrassenCtx(LinalgCtx* ctx, Mat2d A, Mat2d B, Mat2d* result, size_t cutoff, Mat2d* work)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, B.cols);
+    LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(A.cols != B.rows, LINALG_ERROR, "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols);
+    LINALG_ASSERT_ERROR(A.rows != result->rows || B.cols != result->cols, LINALG_ERROR,
+                        "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu) stored in mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols, result->rows, result->cols);
+    LINALG_ASSERT_ERROR(result->mat == A.mat || result->mat == B.mat, LINALG_ERROR, "result matrix can not alias the inputs!");
+
+    if(cutoff == 0) cutoff = LINALG_STRASSEN_CUTOFF;
+    // the recursion needs at least 2x2 blocks to split
+    if(cutoff < 2) cutoff = 2;
+
+    size_t size = mat2DMulStrassenWorkSize(A.rows, A.cols, B.cols, cutoff);
+    LINALG_ASSERT_ERROR(size > 0 && (!work || !work->mat || work->rows * work->cols < size), LINALG_ERROR,
+                        "scratch space should hold at least %zu elements!", size);
+
+    strassenRec(ctx, A.mat, A.cols, B.mat, B.cols, result->mat, result->cols, A.rows, A.cols, B.cols, cutoff, size > 0 ? work->mat : NULL);
+    return LINALG_OK;
+}
+
+// one step of the out of core product: tiles to load for the next step and a finished result tile to store
+typedef struct OocJob
+{
+    // load A(ai.., ak..) and B(ak.., bj..) into a/b, skipped if a is NULL
+    double* a;
+    double* b;
+    size_t ai, ak, bj, tm, tk, tn;
+    // store c(ci.., cj..) into the result, skipped if c is NULL
+    const double* c;
+    size_t ci, cj, cm, cn;
+} OocJob;
+
+typedef struct OocIo
+{
+    Mat2d A;
+    Mat2d B;
+    Mat2d* result;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    OocJob job;
+    int pending;
+    int shutdown;
+} OocIo;
+
+// copy a rowsxcols tile between strided buffers
+static void oocCopy(double* dst, size_t ldd, const double* src, size_t lds, size_t rows, size_t cols)
+{
+    for(size_t i = 0; i < rows; i++) memcpy(dst + i * ldd, src + i * lds, cols * sizeof(double));
+}
+
+static void oocRunJob(OocIo* io, OocJob job)
+{
+    if(job.c)
+    {
+        double* dst = io->result->mat + job.ci * io->result->cols + job.cj;
+        oocCopy(dst, io->result->cols, job.c, job.cn, job.cm, job.cn);
+#ifdef LA_MUL_MSYNC
+        // start writing the rows back now instead of at unmap, does nothing(and fails harmlessly) for memory that isn't file backed
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        uintptr_t begin = (uintptr_t)dst / page * page;
+        uintptr_t end = (uintptr_t)(dst + (job.cm - 1) * io->result->cols + job.cn);
+        msync((void*)begin, end - begin, MS_ASYNC);
+#endif
+    }
+    if(job.a)
     {
-        for(size_t j = 0; j < A.cols; j++)
+        // touching the views here faults their pages in on the io thread, while the caller computes
+        oocCopy(job.a, job.tk, io->A.mat + job.ai * io->A.cols + job.ak, io->A.cols, job.tm, job.tk);
+        oocCopy(job.b, job.tn, io->B.mat + job.ak * io->B.cols + job.bj, io->B.cols, job.tk, job.tn);
+    }
+}
+
+static void* oocIoMain(void* data)
+{
+    OocIo* io = data;
+    pthread_mutex_lock(&io->lock);
+    while(1)
+    {
+        while(!io->pending && !io->shutdown) pthread_cond_wait(&io->cond, &io->lock);
+        if(io->shutdown && !io->pending) break;
+
+        OocJob job = io->job;
+        pthread_mutex_unlock(&io->lock);
+        oocRunJob(io, job);
+        pthread_mutex_lock(&io->lock);
+
+        io->pending = 0;
+        pthread_cond_broadcast(&io->cond);
+    }
+    pthread_mutex_unlock(&io->lock);
+    return NULL;
+}
+
+static void oocSubmit(OocIo* io, OocJob job)
+{
+    pthread_mutex_lock(&io->lock);
+    io->job = job;
+    io->pending = 1;
+    pthread_cond_broadcast(&io->cond);
+    pthread_mutex_unlock(&io->lock);
+}
+
+static void oocWait(OocIo* io)
+{
+    pthread_mutex_lock(&io->lock);
+    while(io->pending) pthread_cond_wait(&io->cond, &io->lock);
+    pthread_mutex_unlock(&io->lock);
+}
+
+// smallest tile edge(unless the dimension is smaller), every step hands off to the io thread which costs microseconds,
+// a step on smaller tiles is too short to hide that
+#define LA_OOC_MIN_TILE 32
+
+// tile edge for a budget of 6 double buffered tiles(A, B and result), a multiple of 4. 0 if budget can't hold the smallest tile
+static size_t oocTile(size_t budget, size_t dim)
+{
+    size_t t = (size_t)sqrt((double)budget / (6.0 * sizeof(double)));
+    if(t >= dim) return dim;
+    if(t < LA_OOC_MIN_TILE) return 0;
+    return t & ~(size_t)3;
+}
+
+// compute result = A*B tile by tile for matrices larger than memory, usually views of .npy files(mat2DLoadNpyMap,
+// result mapped LINALG_MAP_SHARED, e.g. made with mat2DCreateNpy). prints error if the input is invalid
+int mat2DMulOutOfCore(LinalgCtx* ctx, Mat2d A, Mat2d B, Mat2d* result, size_t budget)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, B.cols);
+    LINALG_ASSERT_ERROR(!result || !result->mat || !A.mat || !B.mat, LINALG_ERROR, "input/result matrix is null!");
+    LINALG_ASSERT_ERROR(A.cols != B.rows, LINALG_ERROR, "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols);
+    LINALG_ASSERT_ERROR(A.rows != result->rows || B.cols != result->cols, LINALG_ERROR,
+                        "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu) stored in mat(%zux%zu)", A.rows, A.cols, B.rows, B.cols, result->rows, result->cols);
+    LINALG_ASSERT_ERROR(result->mat == A.mat || result->mat == B.mat, LINALG_ERROR, "result matrix can not alias the inputs!");
+
+    size_t m = A.rows, k = A.cols, n = B.cols;
+    size_t tm = oocTile(budget, m), tk = oocTile(budget, k), tn = oocTile(budget, n);
+    LINALG_ASSERT_ERROR(tm == 0 || tk == 0 || tn == 0, LINALG_ERROR, "memory budget of %zu bytes is too small for a tile!", budget);
+
+    // two of each tile: one is computed on while the io thread fills(or drains) the other
+    size_t a_size = tm * tk, b_size = tk * tn, c_size = tm * tn;
+    double* buffer = malloc(2 * (a_size + b_size + c_size) * sizeof(double));
+    LINALG_ASSERT_ERROR(!buffer, LINALG_ERROR, "unkown error occured when allocation memory!");
+    double* a_buf[2] = { buffer, buffer + a_size };
+    double* b_buf[2] = { buffer + 2 * a_size, buffer + 2 * a_size + b_size };
+    double* c_buf[2] = { buffer + 2 * (a_size + b_size), buffer + 2 * (a_size + b_size) + c_size };
+
+    OocIo io;
+    io.A = A;
+    io.B = B;
+    io.result = result;
+    io.pending = 0;
+    io.shutdown = 0;
+    pthread_mutex_init(&io.lock, NULL);
+    pthread_cond_init(&io.cond, NULL);
+    int threaded = pthread_create(&io.thread, NULL, oocIoMain, &io) == 0;
+    if(!threaded)
+    {
+        LINALG_REPORT_WARN("could not start the io thread, tiles are loaded without overlap!");
+    }
+
+    // steps walk the result tiles row by row and the inner dimension within each tile
+    size_t ktiles = (k + tk - 1) / tk, jtiles = (n + tn - 1) / tn, itiles = (m + tm - 1) / tm;
+    size_t steps = itiles * jtiles * ktiles;
+
+    OocJob first = { a_buf[0], b_buf[0], 0, 0, 0, tm < m ? tm : m, tk < k ? tk : k, tn < n ? tn : n, NULL, 0, 0, 0, 0 };
+    oocRunJob(&io, first);
+
+    // a finished result tile is stored by the io thread during the step after it
+    OocJob store = { NULL, NULL, 0, 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0 };
+    size_t cur = 0, ccur = 0;
+    for(size_t step = 0; step < steps; step++)
+    {
+        size_t kt = step % ktiles, jt = (step / ktiles) % jtiles, it = step / (ktiles * jtiles);
+        size_t i0 = it * tm, j0 = jt * tn, k0 = kt * tk;
+        size_t cm = m - i0 < tm ? m - i0 : tm, cn = n - j0 < tn ? n - j0 : tn, ck = k - k0 < tk ? k - k0 : tk;
+
+        OocJob job = store;
+        if(step + 1 < steps)
+        {
+            size_t nk = (step + 1) % ktiles, nj = ((step + 1) / ktiles) % jtiles, ni = (step + 1) / (ktiles * jtiles);
+            job.a = a_buf[cur ^ 1];
+            job.b = b_buf[cur ^ 1];
+            job.ai = ni * tm;
+            job.ak = nk * tk;
+            job.bj = nj * tn;
+            job.tm = m - job.ai < tm ? m - job.ai : tm;
+            job.tk = k - job.ak < tk ? k - job.ak : tk;
+            job.tn = n - job.bj < tn ? n - job.bj : tn;
+        }
+        if(threaded) oocSubmit(&io, job);
+        else oocRunJob(&io, job);
+        store.c = NULL;
+
+        mat2DMulBlockCtx(ctx, a_buf[cur], ck, b_buf[cur], cn, c_buf[ccur], cn, cm, ck, cn, kt != 0);
+
+        if(threaded) oocWait(&io);
+
+        // the tile is complete, keep working in the other result buffer while it is stored
+        if(kt == ktiles - 1)
         {
-            LA_UNPACK_PTR(result)[j][i] = LA_UNPACK(A)[i][j];
+            store.c = c_buf[ccur];
+            store.ci = i0;
+            store.cj = j0;
+            store.cm = cm;
+            store.cn = cn;
+            ccur ^= 1;
         }
+        cur ^= 1;
+    }
+    oocRunJob(&io, store);
+
+    if(threaded)
+    {
+        pthread_mutex_lock(&io.lock);
+        io.shutdown = 1;
+        pthread_cond_broadcast(&io.cond);
+        pthread_mutex_unlock(&io.lock);
+        pthread_join(io.thread, NULL);
+    }
+    pthread_mutex_destroy(&io.lock);
+    pthread_cond_destroy(&io.cond);
+    free(buffer);
+
+    return LINALG_OK;
+}
+
+typedef struct Mat2DTransposeArgs
+{
+    Mat2d A;
+    Mat2d* result;
+} Mat2DTransposeArgs;
+
+// transpose the row tiles [begin, end)
+static void mat2DTransposeTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    Mat2DTransposeArgs* args = data;
+    (void)thread;
+    size_t row_end = end * LA_TRANSPOSE_TILE < args->A.rows ? end * LA_TRANSPOSE_TILE : args->A.rows;
+    mat2DTransposeRows(args->A, args->result, begin * LA_TRANSPOSE_TILE, row_end);
+}
+static void mat2DTransposeSelfTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    Mat2DTransposeArgs* args = data;
+    (void)thread;
+    mat2DTransposeSelfTiles(args->A, begin, end);
+}
+// compute result = A^T on the threads of ctx(A and result may be the same square matrix). prints error if the input is invalid
+int mat2DTransposeCtx(LinalgCtx* ctx, Mat2d A, Mat2d* result)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, linalgCtxThreads(ctx));
+    if(LINALG_CTX_SERIAL(ctx, A.rows * A.cols)) return mat2DTranspose(A, result);
+
+    LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(!result->mat, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(A.cols != result->rows || A.rows != result->cols, LINALG_ERROR, "invalid operation: multiplication between mat(%zux%zu) and mat(%zux%zu)", A.rows, A.cols, result->rows, result->cols);
+
+    Mat2DTransposeArgs args = { A, result };
+    size_t tiles = (A.rows + LA_TRANSPOSE_TILE - 1) / LA_TRANSPOSE_TILE;
+
+    // a tile row of the in place transpose only touches its own tiles and their mirrors, so tile rows are independent
+    // the work per tile row shrinks towards the bottom, stealing evens it out
+    if(A.mat == result->mat)
+    {
+        LINALG_ASSERT_ERROR(A.rows != A.cols, LINALG_ERROR, "invalid operation: in place transpose of non square matrix mat(%zux%zu)", A.rows, A.cols);
+        linalgParallelFor(ctx, 0, tiles, 1, mat2DTransposeSelfTask, &args);
+        return LINALG_OK;
     }
 
+    linalgParallelFor(ctx, 0, tiles, LINALG_CTX_GRAIN(LA_TRANSPOSE_TILE * A.cols), mat2DTransposeTask, &args);
     return LINALG_OK;
 }
 
 // maximum value in the matrix, prints error if input is invalid
 double mat2DMax(Mat2d a)
 {
+    LINALG_TRACE_SCOPE(a.rows, a.cols, 0);
     LINALG_ASSERT_ERROR(!a.mat, NAN, "input matrix is null!");
     LINALG_ASSERT_WARN(a.rows*a.cols == 0, -INFINITY, "input matrix is null!");
 
@@ -345,6 +1236,7 @@ double mat2DMax(Mat2d a)
 // minimum value in the matrix, prints error if input is invalid
 double mat2DMin(Mat2d a)
 {
+    LINALG_TRACE_SCOPE(a.rows, a.cols, 0);
     LINALG_ASSERT_ERROR(!a.mat, NAN, "input matrix is null!");
     LINALG_ASSERT_WARN(a.rows*a.cols == 0, INFINITY, "input matrix is null!");
 
@@ -367,6 +1259,7 @@ void freeMat2D(Mat2d* mat)
 
 MatTriDiag triDiagInitA(double value, size_t n)
 {
+    LINALG_TRACE_SCOPE(n, 0, 0);
     MatTriDiag mat;
     mat.diagonal = vecInitA(value, n);
     mat.subdiagonal = vecInitA(value, n);
@@ -384,6 +1277,7 @@ MatTriDiag triDiagInitZeroA(size_t n)
 // add 2 tridiagonal matrixes and get result into another tridiagonal matrix, prints error if input is invalid
 int triDiagAdd(MatTriDiag a, MatTriDiag b, MatTriDiag* result)
 {
+    LINALG_TRACE_SCOPE(a.diagonal.len, 0, 0);
     vecAdd(a.diagonal, b.diagonal, &result->diagonal);
     vecAdd(a.subdiagonal, b.subdiagonal, &result->subdiagonal);
     vecAdd(a.superdiagonal, b.superdiagonal, &result->superdiagonal);
@@ -393,6 +1287,7 @@ int triDiagAdd(MatTriDiag a, MatTriDiag b, MatTriDiag* result)
 // subtract 2 tridiagonal matrixes (a - b) and get result into another tridiagonal matrix, prints error if input is invalid
 int triDiagSub(MatTriDiag a, MatTriDiag b, MatTriDiag* result)
 {
+    LINALG_TRACE_SCOPE(a.diagonal.len, 0, 0);
     vecSub(a.diagonal, b.diagonal, &result->diagonal);
     vecSub(a.subdiagonal, b.subdiagonal, &result->subdiagonal);
     vecSub(a.superdiagonal, b.superdiagonal, &result->superdiagonal);
@@ -402,6 +1297,7 @@ int triDiagSub(MatTriDiag a, MatTriDiag b, MatTriDiag* result)
 // multiply scalar value to tridiagonal matrix and get result into another tridiagonal matrix, prints error if input is invalid
 int triDiagScale(double a, MatTriDiag b, MatTriDiag* result)
 {
+    LINALG_TRACE_SCOPE(b.diagonal.len, 0, 0);
     vecScale(a, b.diagonal, &result->diagonal);
     vecScale(a, b.subdiagonal, &result->subdiagonal);
     vecScale(a, b.superdiagonal, &result->superdiagonal);
@@ -412,12 +1308,14 @@ int triDiagScale(double a, MatTriDiag b, MatTriDiag* result)
 // add vec to diagonal entries
 int triDiagAddDiagonalSelf(MatTriDiag* a, Vec diag)
 {
+    LINALG_TRACE_SCOPE(a->diagonal.len, 0, 0);
     vecAdd(a->diagonal, diag, &a->diagonal);
     return LINALG_OK;
 }
 // add vec to diagonal entries
 int triDiagSubDiagonalSelf(MatTriDiag* a, Vec diag)
 {
+    LINALG_TRACE_SCOPE(a->diagonal.len, 0, 0);
     vecSub(a->diagonal, diag, &a->diagonal);
     return LINALG_OK;
 }
@@ -425,6 +1323,7 @@ int triDiagSubDiagonalSelf(MatTriDiag* a, Vec diag)
 // solve Ax = b using tridiagonal matrix algorithm
 void triDiagSolveDestructive(MatTriDiag* A, Vec* x)
 {
+    LINALG_TRACE_SCOPE(A->diagonal.len, 0, 0);
     VEC_INDEX(A->scratch, 0) = VEC_INDEX(A->superdiagonal, 0) / VEC_INDEX(A->diagonal, 0);
     VEC_INDEX(*x, 0) = VEC_INDEX(*x, 0) / VEC_INDEX(A->diagonal, 0);
 
@@ -444,6 +1343,361 @@ void triDiagSolveDestructive(MatTriDiag* A, Vec* x)
     VEC_INDEX(*x, 0) -= VEC_INDEX(A->scratch, 0) * VEC_INDEX(*x, 1);
 }
 
+// x -= a * y over a row of right hand sides
+static void triDiagRowAxpy(double a, const double* restrict y, double* restrict x, size_t k)
+{
+    for(size_t c = 0; c < k; c++) x[c] -= a * y[c];
+}
+
+// solve AX = B for every column of X using tridiagonal matrix algorithm
+void triDiagSolveMultiDestructive(MatTriDiag* A, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(A->diagonal.len, X ? X->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!X || !X->mat, , "input/output is null!");
+    LINALG_ASSERT_ERROR(X->rows != A->diagonal.len, , "invalid operation: tridiagonal matrix(%zu) applied over mat(%zux%zu)", A->diagonal.len, X->rows, X->cols);
+
+    size_t n = X->rows, k = X->cols;
+    double* sub = A->subdiagonal.x;
+    double* diag = A->diagonal.x;
+    double* super = A->superdiagonal.x;
+    double* scratch = A->scratch.x;
+    size_t ss = A->subdiagonal.offset, ds = A->diagonal.offset, us = A->superdiagonal.offset, cs = A->scratch.offset;
+
+    // one forward sweep computes each coefficient once and applies it to a whole row of X,
+    // so the matrix is streamed twice no matter how many columns X has
+    double inv = 1.0 / diag[0];
+    if(n > 1) scratch[0] = super[0] * inv;
+    for(size_t c = 0; c < k; c++) X->mat[c] *= inv;
+
+    for(size_t i = 1; i < n; i++)
+    {
+        double l = sub[i * ss];
+        inv = 1.0 / (diag[i * ds] - l * scratch[(i - 1) * cs]);
+        if(i < n - 1) scratch[i * cs] = super[i * us] * inv;
+
+        double* row = X->mat + i * k;
+        triDiagRowAxpy(l, row - k, row, k);
+        for(size_t c = 0; c < k; c++) row[c] *= inv;
+    }
+
+    for(size_t i = n - 1; i-- > 0;) triDiagRowAxpy(scratch[i * cs], X->mat + (i + 1) * k, X->mat + i * k, k);
+}
+
+// thomas sweep for (A + sigma I + diag(d))x = b, d may be NULL. A is only read, the coefficients go to scratch
+static inline void triDiagShiftedSweep(const MatTriDiag* A, double sigma, const Vec* d, Vec* x, Vec* scratch)
+{
+    size_t n = A->diagonal.len;
+    const double* sub = A->subdiagonal.x;
+    const double* diag = A->diagonal.x;
+    const double* super = A->superdiagonal.x;
+    const double* shift = d ? d->x : NULL;
+    double* c = scratch->x;
+    double* b = x->x;
+    size_t ss = A->subdiagonal.offset, ds = A->diagonal.offset, us = A->superdiagonal.offset;
+    size_t hs = d ? d->offset : 0, cs = scratch->offset, bs = x->offset;
+
+    // the shift is added to each pivot as it is formed, the diagonal of A is never written
+    double inv = 1.0 / (diag[0] + sigma + (shift ? shift[0] : 0.0));
+    if(n > 1) c[0] = super[0] * inv;
+    b[0] *= inv;
+
+    for(size_t i = 1; i < n; i++)
+    {
+        double l = sub[i * ss];
+        inv = 1.0 / (diag[i * ds] + sigma + (shift ? shift[i * hs] : 0.0) - l * c[(i - 1) * cs]);
+        if(i < n - 1) c[i * cs] = super[i * us] * inv;
+        b[i * bs] = (b[i * bs] - l * b[(i - 1) * bs]) * inv;
+    }
+
+    for(size_t i = n - 1; i-- > 0;) b[i * bs] -= c[i * cs] * b[(i + 1) * bs];
+}
+
+// solve (A + sigma I)x = b using tridiagonal matrix algorithm, x holds b on entry
+// A is not modified(scratch should be n elements big), so several shifts can be solved concurrently
+int triDiagSolveShifted(MatTriDiag A, double sigma, Vec* x, Vec* scratch)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, 0, 0);
+    LINALG_ASSERT_ERROR(!x || !x->x || !scratch || !scratch->x, LINALG_ERROR, "input/output or scratch space is null!");
+    LINALG_ASSERT_ERROR(x->len != A.diagonal.len || scratch->len < A.diagonal.len, LINALG_ERROR,
+                        "invalid operation: tridiagonal matrix(%zu) applied over vec(%zu) with scratch(%zu)", A.diagonal.len, x->len, scratch->len);
+
+    if(A.diagonal.len == 0) return LINALG_OK;
+    triDiagShiftedSweep(&A, sigma, NULL, x, scratch);
+    return LINALG_OK;
+}
+// solve (A + diag(d))x = b using tridiagonal matrix algorithm, x holds b on entry
+// A is not modified(scratch should be n elements big), so several shifts can be solved concurrently
+int triDiagSolveShiftedDiag(MatTriDiag A, Vec d, Vec* x, Vec* scratch)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, 0, 0);
+    LINALG_ASSERT_ERROR(!x || !x->x || !scratch || !scratch->x || !d.x, LINALG_ERROR, "input/output, shift or scratch space is null!");
+    LINALG_ASSERT_ERROR(x->len != A.diagonal.len || d.len != A.diagonal.len || scratch->len < A.diagonal.len, LINALG_ERROR,
+                        "invalid operation: tridiagonal matrix(%zu) shifted by vec(%zu) applied over vec(%zu) with scratch(%zu)",
+                        A.diagonal.len, d.len, x->len, scratch->len);
+
+    if(A.diagonal.len == 0) return LINALG_OK;
+    triDiagShiftedSweep(&A, 0.0, &d, x, scratch);
+    return LINALG_OK;
+}
+
+// rows solved together by a row sweep, and columns of them transposed into a tile at a time
+#define LA_LINES_GROUP 8
+#define LA_LINES_TILE 64
+
+// thomas coefficients of (A + sigma I): c[i] = super[i] * p[i] with the inverted pivots p[i], strided by cs
+static void triDiagLinesFactor(const MatTriDiag* A, double sigma, double* c, double* p, size_t cs)
+{
+    size_t n = A->diagonal.len;
+    const double* sub = A->subdiagonal.x;
+    const double* diag = A->diagonal.x;
+    const double* super = A->superdiagonal.x;
+    size_t ss = A->subdiagonal.offset, ds = A->diagonal.offset, us = A->superdiagonal.offset;
+
+    p[0] = 1.0 / (diag[0] + sigma);
+    c[0] = n > 1 ? super[0] * p[0] : 0.0;
+    for(size_t i = 1; i < n; i++)
+    {
+        p[i * cs] = 1.0 / (diag[i * ds] + sigma - sub[i * ss] * c[(i - 1) * cs]);
+        c[i * cs] = i < n - 1 ? super[i * us] * p[i * cs] : 0.0;
+    }
+}
+
+typedef struct TriDiagLinesArgs
+{
+    const MatTriDiag* A;
+    double sigma;
+    // factored coefficients(see triDiagLinesFactor)
+    const double* c;
+    const double* p;
+    size_t cs;
+    const Mat2d* in;
+    Mat2d* out;
+} TriDiagLinesArgs;
+
+// sweep columns [begin, end) of X, the same elimination applied to a contiguous segment of each row
+static void triDiagSolveColsTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    (void)thread;
+    TriDiagLinesArgs* args = data;
+    const double* sub = args->A->subdiagonal.x;
+    const double* c = args->c;
+    const double* p = args->p;
+    size_t ss = args->A->subdiagonal.offset, cs = args->cs;
+    size_t n = args->out->rows, k = args->out->cols, w = end - begin;
+    double* x = args->out->mat + begin;
+
+    for(size_t j = 0; j < w; j++) x[j] *= p[0];
+    for(size_t i = 1; i < n; i++)
+    {
+        double l = sub[i * ss], inv = p[i * cs];
+        double* restrict row = x + i * k;
+        const double* restrict prev = row - k;
+        for(size_t j = 0; j < w; j++) row[j] = (row[j] - l * prev[j]) * inv;
+    }
+    for(size_t i = n - 1; i-- > 0;)
+    {
+        double u = c[i * cs];
+        double* restrict row = x + i * k;
+        const double* restrict next = row + k;
+        for(size_t j = 0; j < w; j++) row[j] -= u * next[j];
+    }
+}
+
+// move columns [j0, j0 + w) of g rows between X and a tile holding them transposed(tile[j][r])
+static inline void triDiagLinesGather(double tile[LA_LINES_TILE][LA_LINES_GROUP], const double* x, size_t k, size_t g, size_t j0, size_t w)
+{
+    for(size_t r = 0; r < g; r++)
+        for(size_t j = 0; j < w; j++) tile[j][r] = x[r * k + j0 + j];
+}
+static inline void triDiagLinesScatter(double tile[LA_LINES_TILE][LA_LINES_GROUP], double* x, size_t k, size_t g, size_t j0, size_t w)
+{
+    for(size_t r = 0; r < g; r++)
+        for(size_t j = 0; j < w; j++) x[r * k + j0 + j] = tile[j][r];
+}
+
+// sweep rows [begin, end) of X, LA_LINES_GROUP rows at a time. the rows are transposed tile by tile so the
+// recurrence runs along the tile with the rows side by side, instead of one row at a time
+static void triDiagSolveRowsTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    (void)thread;
+    TriDiagLinesArgs* args = data;
+    const double* sub = args->A->subdiagonal.x;
+    const double* c = args->c;
+    const double* p = args->p;
+    size_t ss = args->A->subdiagonal.offset, cs = args->cs;
+    size_t n = args->out->cols;
+
+    double tile[LA_LINES_TILE][LA_LINES_GROUP];
+    double carry[LA_LINES_GROUP];
+
+    for(size_t r0 = begin; r0 < end; r0 += LA_LINES_GROUP)
+    {
+        size_t g = end - r0 < LA_LINES_GROUP ? end - r0 : LA_LINES_GROUP;
+        double* x = args->out->mat + r0 * n;
+        // lanes past the last row of a short group would hold rows of the previous group, zero them once here.
+        // gather never writes them and sweeping zeros with a zero carry keeps them zero, they are never stored
+        if(g < LA_LINES_GROUP) memset(tile, 0, sizeof(tile));
+
+        for(size_t r = 0; r < LA_LINES_GROUP; r++) carry[r] = 0.0;
+        for(size_t j0 = 0; j0 < n; j0 += LA_LINES_TILE)
+        {
+            size_t w = n - j0 < LA_LINES_TILE ? n - j0 : LA_LINES_TILE;
+            triDiagLinesGather(tile, x, n, g, j0, w);
+            for(size_t j = 0; j < w; j++)
+            {
+                // carry is zero before the first column, so its (zero) subdiagonal entry is never read
+                double l = j0 + j > 0 ? sub[(j0 + j) * ss] : 0.0, inv = p[(j0 + j) * cs];
+                for(size_t r = 0; r < LA_LINES_GROUP; r++) carry[r] = tile[j][r] = (tile[j][r] - l * carry[r]) * inv;
+            }
+            triDiagLinesScatter(tile, x, n, g, j0, w);
+        }
+
+        for(size_t r = 0; r < LA_LINES_GROUP; r++) carry[r] = 0.0;
+        for(size_t j0 = (n - 1) / LA_LINES_TILE * LA_LINES_TILE;; j0 -= LA_LINES_TILE)
+        {
+            size_t w = n - j0 < LA_LINES_TILE ? n - j0 : LA_LINES_TILE;
+            triDiagLinesGather(tile, x, n, g, j0, w);
+            for(size_t j = w; j-- > 0;)
+            {
+                // c is zero for the last column
+                double u = c[(j0 + j) * cs];
+                for(size_t r = 0; r < LA_LINES_GROUP; r++) carry[r] = tile[j][r] -= u * carry[r];
+            }
+            triDiagLinesScatter(tile, x, n, g, j0, w);
+            if(j0 == 0) break;
+        }
+    }
+}
+
+// out = (sigma I - A) in along the columns, for rows [begin, end)
+static void triDiagApplyColsTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    (void)thread;
+    TriDiagLinesArgs* args = data;
+    const MatTriDiag* A = args->A;
+    size_t n = args->in->rows, k = args->in->cols;
+
+    for(size_t i = begin; i < end; i++)
+    {
+        double l = i > 0 ? A->subdiagonal.x[i * A->subdiagonal.offset] : 0.0;
+        double d = args->sigma - A->diagonal.x[i * A->diagonal.offset];
+        double u = i < n - 1 ? A->superdiagonal.x[i * A->superdiagonal.offset] : 0.0;
+        const double* restrict x = args->in->mat + i * k;
+        // rows outside the grid are multiplied by zero, point them at row i to stay in bounds
+        const double* restrict above = i > 0 ? x - k : x;
+        const double* restrict below = i < n - 1 ? x + k : x;
+        double* restrict y = args->out->mat + i * k;
+        for(size_t j = 0; j < k; j++) y[j] = d * x[j] - l * above[j] - u * below[j];
+    }
+}
+
+// out = (sigma I - A) in along the rows, for rows [begin, end)
+static void triDiagApplyRowsTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    (void)thread;
+    TriDiagLinesArgs* args = data;
+    const double* sub = args->A->subdiagonal.x;
+    const double* diag = args->A->diagonal.x;
+    const double* super = args->A->superdiagonal.x;
+    size_t ss = args->A->subdiagonal.offset, ds = args->A->diagonal.offset, us = args->A->superdiagonal.offset;
+    size_t k = args->in->cols;
+    double sigma = args->sigma;
+
+    for(size_t i = begin; i < end; i++)
+    {
+        const double* restrict x = args->in->mat + i * k;
+        double* restrict y = args->out->mat + i * k;
+        if(k == 1)
+        {
+            y[0] = (sigma - diag[0]) * x[0];
+            continue;
+        }
+        y[0] = (sigma - diag[0]) * x[0] - super[0] * x[1];
+        for(size_t j = 1; j < k - 1; j++) y[j] = (sigma - diag[j * ds]) * x[j] - sub[j * ss] * x[j - 1] - super[j * us] * x[j + 1];
+        y[k - 1] = (sigma - diag[(k - 1) * ds]) * x[k - 1] - sub[(k - 1) * ss] * x[k - 2];
+    }
+}
+
+static void triDiagSolveColsRun(LinalgCtx* ctx, TriDiagLinesArgs* args)
+{
+    size_t grain = (LINALG_CTX_GRAIN(3 * args->out->rows) + 7) & ~(size_t)7;
+    linalgParallelFor(ctx, 0, args->out->cols, grain, triDiagSolveColsTask, args);
+}
+static void triDiagSolveRowsRun(LinalgCtx* ctx, TriDiagLinesArgs* args)
+{
+    size_t grain = (LINALG_CTX_GRAIN(3 * args->out->cols) + LA_LINES_GROUP - 1) / LA_LINES_GROUP * LA_LINES_GROUP;
+    linalgParallelFor(ctx, 0, args->out->rows, grain, triDiagSolveRowsTask, args);
+}
+
+// solve (A + sigma I)x = b along every row of X on the threads of ctx, X holds b on entry
+int triDiagSolveRowsCtx(LinalgCtx* ctx, MatTriDiag A, double sigma, Mat2d* X, Vec* scratch)
+{
+    LINALG_TRACE_SCOPE(X ? X->rows : 0, X ? X->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!X || !X->mat || !scratch || !scratch->x, LINALG_ERROR, "input/output or scratch space is null!");
+    LINALG_ASSERT_ERROR(X->cols != A.diagonal.len || scratch->len < 2 * A.diagonal.len, LINALG_ERROR,
+                        "invalid operation: tridiagonal matrix(%zu) applied over the rows of mat(%zux%zu) with scratch(%zu)",
+                        A.diagonal.len, X->rows, X->cols, scratch->len);
+
+    if(X->rows == 0 || X->cols == 0) return LINALG_OK;
+    size_t n = A.diagonal.len;
+    TriDiagLinesArgs args = { &A, sigma, scratch->x, scratch->x + n * scratch->offset, scratch->offset, X, X };
+    triDiagLinesFactor(&A, sigma, scratch->x, scratch->x + n * scratch->offset, scratch->offset);
+    triDiagSolveRowsRun(ctx, &args);
+    return LINALG_OK;
+}
+// solve (A + sigma I)x = b along every column of X on the threads of ctx, X holds b on entry
+int triDiagSolveColsCtx(LinalgCtx* ctx, MatTriDiag A, double sigma, Mat2d* X, Vec* scratch)
+{
+    LINALG_TRACE_SCOPE(X ? X->rows : 0, X ? X->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!X || !X->mat || !scratch || !scratch->x, LINALG_ERROR, "input/output or scratch space is null!");
+    LINALG_ASSERT_ERROR(X->rows != A.diagonal.len || scratch->len < 2 * A.diagonal.len, LINALG_ERROR,
+                        "invalid operation: tridiagonal matrix(%zu) applied over the columns of mat(%zux%zu) with scratch(%zu)",
+                        A.diagonal.len, X->rows, X->cols, scratch->len);
+
+    if(X->rows == 0 || X->cols == 0) return LINALG_OK;
+    size_t n = A.diagonal.len;
+    TriDiagLinesArgs args = { &A, sigma, scratch->x, scratch->x + n * scratch->offset, scratch->offset, X, X };
+    triDiagLinesFactor(&A, sigma, scratch->x, scratch->x + n * scratch->offset, scratch->offset);
+    triDiagSolveColsRun(ctx, &args);
+    return LINALG_OK;
+}
+
+// one peaceman-rachford step for U' = -(Ax + Ay)U on the threads of ctx, sigma = 2 / dt:
+// (Ax + sigma I)W = (sigma I - Ay)U, then (Ay + sigma I)U = (sigma I - Ax)W
+int triDiagAdiStepCtx(LinalgCtx* ctx, MatTriDiag Ax, MatTriDiag Ay, double sigma, Mat2d* U, Mat2d* work, Vec* scratch)
+{
+    LINALG_TRACE_SCOPE(U ? U->rows : 0, U ? U->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!U || !U->mat || !work || !work->mat || !scratch || !scratch->x, LINALG_ERROR, "grid, work or scratch space is null!");
+    LINALG_ASSERT_ERROR(U->cols != Ax.diagonal.len || U->rows != Ay.diagonal.len, LINALG_ERROR,
+                        "invalid operation: tridiagonal matrices(%zu, %zu) applied over mat(%zux%zu)", Ax.diagonal.len, Ay.diagonal.len, U->rows, U->cols);
+    LINALG_ASSERT_ERROR(work->rows != U->rows || work->cols != U->cols || work->mat == U->mat, LINALG_ERROR,
+                        "work mat(%zux%zu) must be a separate mat(%zux%zu)", work->rows, work->cols, U->rows, U->cols);
+    LINALG_ASSERT_ERROR(scratch->len < 2 * (U->rows + U->cols), LINALG_ERROR, "scratch(%zu) should be %zu elements big!", scratch->len, 2 * (U->rows + U->cols));
+
+    if(U->rows == 0 || U->cols == 0) return LINALG_OK;
+    size_t rows = U->rows, cols = U->cols, cs = scratch->offset;
+    double* cx = scratch->x;
+    double* cy = cx + 2 * cols * cs;
+    triDiagLinesFactor(&Ax, sigma, cx, cx + cols * cs, cs);
+    triDiagLinesFactor(&Ay, sigma, cy, cy + rows * cs, cs);
+
+    size_t grain = LINALG_CTX_GRAIN(5 * cols);
+    TriDiagLinesArgs x_args = { &Ax, sigma, cx, cx + cols * cs, cs, work, work };
+    TriDiagLinesArgs y_args = { &Ay, sigma, cy, cy + rows * cs, cs, U, work };
+
+    // explicit half in y, implicit in x
+    linalgParallelFor(ctx, 0, rows, grain, triDiagApplyColsTask, &y_args);
+    triDiagSolveRowsRun(ctx, &x_args);
+
+    // explicit half in x, implicit in y
+    x_args.out = U;
+    linalgParallelFor(ctx, 0, rows, grain, triDiagApplyRowsTask, &x_args);
+    y_args.out = U;
+    triDiagSolveColsRun(ctx, &y_args);
+
+    return LINALG_OK;
+}
+
 void freeMatTriDiag(MatTriDiag* mat)
 {
     freeVec(&mat->diagonal);
@@ -452,6 +1706,141 @@ void freeMatTriDiag(MatTriDiag* mat)
     freeVec(&mat->scratch);
 }
 
+// rows are allocated on cache line boundaries, so a row never straddles two lines
+#define LA_TRIDIAG_PACKED_ALIGN 64
+
+// initialize a packed tridiagonal matrix with every entry set to value
+MatTriDiagPacked triDiagPackedInitA(double value, size_t n)
+{
+    LINALG_TRACE_SCOPE(n, 0, 0);
+    MatTriDiagPacked mat = { NULL, 0 };
+    size_t size = (n * sizeof(TriDiagRow) + LA_TRIDIAG_PACKED_ALIGN - 1) / LA_TRIDIAG_PACKED_ALIGN * LA_TRIDIAG_PACKED_ALIGN;
+    mat.rows = aligned_alloc(LA_TRIDIAG_PACKED_ALIGN, size ? size : LA_TRIDIAG_PACKED_ALIGN);
+    LINALG_ASSERT_ERROR(!mat.rows, mat, "unkown error occured when allocation memory!");
+
+    mat.len = n;
+    for(size_t i = 0; i < n; i++) mat.rows[i] = (TriDiagRow){ value, value, value, value };
+
+    return mat;
+}
+MatTriDiagPacked triDiagPackedInitZeroA(size_t n)
+{
+    return triDiagPackedInitA(0.0, n);
+}
+
+// copy A into the packed layout of result(same size). prints error if the input is invalid
+int triDiagPack(MatTriDiag A, MatTriDiagPacked* result)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, 0, 0);
+    LINALG_ASSERT_ERROR(!result || !result->rows, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(A.diagonal.len != result->len, LINALG_ERROR, "invalid operation: packing tridiagonal matrix(%zu) into packed matrix(%zu)", A.diagonal.len, result->len);
+
+    for(size_t i = 0; i < result->len; i++)
+    {
+        TriDiagRow* row = &result->rows[i];
+        row->sub = A.subdiagonal.x[i * A.subdiagonal.offset];
+        row->diag = A.diagonal.x[i * A.diagonal.offset];
+        row->super = A.superdiagonal.x[i * A.superdiagonal.offset];
+        row->scratch = 0.0;
+    }
+    return LINALG_OK;
+}
+// copy A into a new packed matrix(allocates memory)
+MatTriDiagPacked triDiagPackA(MatTriDiag A)
+{
+    LINALG_TRACE_SCOPE(A.diagonal.len, 0, 0);
+    MatTriDiagPacked result = triDiagPackedInitZeroA(A.diagonal.len);
+    if(result.rows) triDiagPack(A, &result);
+    return result;
+}
+// copy packed A back into the separate diagonals of result(same size). prints error if the input is invalid
+int triDiagUnpack(MatTriDiagPacked A, MatTriDiag* result)
+{
+    LINALG_TRACE_SCOPE(A.len, 0, 0);
+    LINALG_ASSERT_ERROR(!result, LINALG_ERROR, "result matrix is null!");
+    LINALG_ASSERT_ERROR(A.len != result->diagonal.len, LINALG_ERROR, "invalid operation: unpacking packed matrix(%zu) into tridiagonal matrix(%zu)", A.len, result->diagonal.len);
+
+    for(size_t i = 0; i < A.len; i++)
+    {
+        result->subdiagonal.x[i * result->subdiagonal.offset] = A.rows[i].sub;
+        result->diagonal.x[i * result->diagonal.offset] = A.rows[i].diag;
+        result->superdiagonal.x[i * result->superdiagonal.offset] = A.rows[i].super;
+    }
+    return LINALG_OK;
+}
+
+// solve Ax = b using tridiagonal matrix algorithm, the scratch column of A is overwritten
+// a row's coefficients arrive in one cache line, so the sweep streams two arrays instead of five
+void triDiagPackedSolveDestructive(MatTriDiagPacked* A, Vec* x)
+{
+    LINALG_TRACE_SCOPE(A->len, 0, 0);
+    LINALG_ASSERT_ERROR(!x || !x->x, , "input/output is null!");
+    LINALG_ASSERT_ERROR(x->len != A->len, , "invalid operation: tridiagonal matrix(%zu) applied over vec(%zu)", A->len, x->len);
+    if(A->len == 0) return;
+
+    size_t n = A->len, bs = x->offset;
+    TriDiagRow* rows = A->rows;
+    double* b = x->x;
+
+    double inv = 1.0 / rows[0].diag;
+    rows[0].scratch = rows[0].super * inv;
+    b[0] *= inv;
+
+    for(size_t i = 1; i < n; i++)
+    {
+        TriDiagRow* row = &rows[i];
+        inv = 1.0 / (row->diag - row->sub * rows[i - 1].scratch);
+        row->scratch = row->super * inv;
+        b[i * bs] = (b[i * bs] - row->sub * b[(i - 1) * bs]) * inv;
+    }
+
+    for(size_t i = n - 1; i-- > 0;) b[i * bs] -= rows[i].scratch * b[(i + 1) * bs];
+}
+
+// compute result = Ax. prints error if the input is invalid
+int triDiagPackedTransform(MatTriDiagPacked A, Vec x, Vec* result)
+{
+    LINALG_TRACE_SCOPE(A.len, 0, 0);
+    LINALG_ASSERT_ERROR(!result || !result->x, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(x.len != A.len || result->len != A.len, LINALG_ERROR,
+                        "invalid operation: tridiagonal matrix(%zu) applied over vec(%zu) stored in vec(%zu)", A.len, x.len, result->len);
+    LINALG_ASSERT_ERROR(result->x == x.x, LINALG_ERROR, "result can not alias the input!");
+    if(A.len == 0) return LINALG_OK;
+
+    size_t n = A.len, xs = x.offset, rs = result->offset;
+    const TriDiagRow* rows = A.rows;
+
+    if(n == 1)
+    {
+        result->x[0] = rows[0].diag * x.x[0];
+        return LINALG_OK;
+    }
+
+    result->x[0] = rows[0].diag * x.x[0] + rows[0].super * x.x[xs];
+    for(size_t i = 1; i < n - 1; i++)
+    {
+        result->x[i * rs] = rows[i].sub * x.x[(i - 1) * xs] + rows[i].diag * x.x[i * xs] + rows[i].super * x.x[(i + 1) * xs];
+    }
+    result->x[(n - 1) * rs] = rows[n - 1].sub * x.x[(n - 2) * xs] + rows[n - 1].diag * x.x[(n - 1) * xs];
+    return LINALG_OK;
+}
+// compute result = Ax(allocates result Vec). prints error if the input is invalid
+Vec triDiagPackedTransformA(MatTriDiagPacked A, Vec x)
+{
+    LINALG_TRACE_SCOPE(A.len, 0, 0);
+    Vec result = vecInitZerosA(A.len);
+    if(triDiagPackedTransform(A, x, &result) != LINALG_OK) freeVec(&result);
+
+    return result;
+}
+
+void freeMatTriDiagPacked(MatTriDiagPacked* mat)
+{
+    free(mat->rows);
+    mat->rows = NULL;
+    mat->len = 0;
+}
+
 Vec2 vec2Add(Vec2 a, Vec2 b)
 {
     Vec2 r;
@@ -534,6 +1923,7 @@ double blkDeterminant(Block2 A)
 
 MatBlock2TD blkTriDiagInitA(double value, size_t n)
 {
+    LINALG_TRACE_SCOPE(n, 0, 0);
     MatBlock2TD matBlk2;
     matBlk2.len = n;
     matBlk2.diagonal = malloc(matBlk2.len * sizeof(Block2));
@@ -548,6 +1938,8 @@ MatBlock2TD blkTriDiagInitA(double value, size_t n)
         matBlk2.superdiagonal[i] = blkInit(value);
         matBlk2.scratch[i] = blkInit(value);
     }
+
+    return matBlk2;
 }
 MatBlock2TD blkTriDiagInitZeroA(size_t n)
 {
@@ -557,6 +1949,7 @@ MatBlock2TD blkTriDiagInitZeroA(size_t n)
 // solve Ax = b using block tridiagonal matrix algorithm
 void blkTriDiagSolveSelf(MatBlock2TD* A, Vec2* x)
 {
+    LINALG_TRACE_SCOPE(A->len, 0, 0);
     Block2 inv = blkInverse(A->diagonal[0]);
 
     A->scratch[0] = blkMul(inv, A->superdiagonal[0]);
@@ -582,6 +1975,37 @@ void blkTriDiagSolveSelf(MatBlock2TD* A, Vec2* x)
     x[0] = vec2Sub(x[0], blkTransform(A->scratch[0], x[1]));
 }
 
+// factorize A in place for blkTriDiagFactorSolve, the diagonal is overwritten with the inverted pivot blocks
+// and scratch with inv(pivot) * superdiagonal, the subdiagonal is kept
+void blkTriDiagFactorSelf(MatBlock2TD* A)
+{
+    LINALG_TRACE_SCOPE(A->len, 0, 0);
+    for(size_t ix = 0; ix < A->len; ix++)
+    {
+        Block2 Factor = ix == 0 ? A->diagonal[0] : blkSub(A->diagonal[ix], blkMul(A->subdiagonal[ix], A->scratch[ix - 1]));
+        A->diagonal[ix] = blkInverse(Factor);
+        if(ix < A->len - 1) A->scratch[ix] = blkMul(A->diagonal[ix], A->superdiagonal[ix]);
+    }
+}
+
+// solve Ax = b using a factorization from blkTriDiagFactorSelf, x holds b on entry. F is not modified
+void blkTriDiagFactorSolve(MatBlock2TD F, Vec2* x)
+{
+    LINALG_TRACE_SCOPE(F.len, 0, 0);
+    if(F.len == 0) return;
+
+    x[0] = blkTransform(F.diagonal[0], x[0]);
+    for(size_t ix = 1; ix < F.len; ix++)
+    {
+        x[ix] = blkTransform(F.diagonal[ix], vec2Sub(x[ix], blkTransform(F.subdiagonal[ix], x[ix - 1])));
+    }
+
+    for(size_t ix = F.len - 1; ix > 0; ix--)
+    {
+        x[ix - 1] = vec2Sub(x[ix - 1], blkTransform(F.scratch[ix - 1], x[ix]));
+    }
+}
+
 void freeMatBlock2TD(MatBlock2TD* mat)
 {
     free(mat->superdiagonal);
@@ -0,0 +1,255 @@
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+#include <float.h>
+
+// maximum refinement steps of mat2DSqSolveMixed(same as LAPACK dsgesv)
+#define LA_MIXED_MAX_ITER 30
+
+// initialize the vector on the heap to zeros
+VecF vecFInitZerosA(size_t len)
+{
+    LINALG_TRACE_SCOPE(len, 0, 0);
+    if(len == 0)
+    {
+        LINALG_REPORT_ERROR("invalid zero length vector requested!");
+        return (VecF){ NULL, 0, 0 };
+    }
+    VecF x = { (float*)calloc(len, sizeof(float)), len, 1 };
+    LINALG_ASSERT_ERROR(!x.x, x, "unkown error occured when allocation memory!");
+    return x;
+}
+// initialize the matrix on the heap to zeros
+Mat2dF mat2DFInitZerosA(size_t rows, size_t cols)
+{
+    LINALG_TRACE_SCOPE(rows, cols, 0);
+    if(rows == 0 || cols == 0)
+    {
+        LINALG_REPORT_ERROR("invalid zero row or col matrix requested!");
+        return (Mat2dF){ NULL, 0, 0 };
+    }
+    Mat2dF mat = { (float*)calloc(rows*cols, sizeof(float)), rows, cols };
+    LINALG_ASSERT_ERROR(!mat.mat, mat, "unkown error occured when allocation memory!");
+    return mat;
+}
+
+// round a double vector to floats, prints error if input is invalid
+int vecToF(Vec src, VecF* dst)
+{
+    LINALG_TRACE_SCOPE(src.len, 0, 0);
+    LINALG_ASSERT_ERROR(!dst || !dst->x || !src.x, LINALG_ERROR, "input/output vector is null!");
+    LINALG_ASSERT_ERROR(src.len != dst->len, LINALG_ERROR, "attempt to convert vectors with unqeual dimensions %zu to %zu!", src.len, dst->len);
+    for(size_t i = 0; i < src.len; i++) dst->x[i * dst->offset] = (float)src.x[i * src.offset];
+    return LINALG_OK;
+}
+// widen a float vector to doubles, prints error if input is invalid
+int vecFromF(VecF src, Vec* dst)
+{
+    LINALG_TRACE_SCOPE(src.len, 0, 0);
+    LINALG_ASSERT_ERROR(!dst || !dst->x || !src.x, LINALG_ERROR, "input/output vector is null!");
+    LINALG_ASSERT_ERROR(src.len != dst->len, LINALG_ERROR, "attempt to convert vectors with unqeual dimensions %zu to %zu!", src.len, dst->len);
+    for(size_t i = 0; i < src.len; i++) dst->x[i * dst->offset] = (double)src.x[i * src.offset];
+    return LINALG_OK;
+}
+// round a double matrix to floats, prints error if input is invalid
+int mat2DToF(Mat2d src, Mat2dF* dst)
+{
+    LINALG_TRACE_SCOPE(src.rows, src.cols, 0);
+    LINALG_ASSERT_ERROR(!dst || !dst->mat || !src.mat, LINALG_ERROR, "input/output matrix is null!");
+    LINALG_ASSERT_ERROR(src.rows != dst->rows || src.cols != dst->cols, LINALG_ERROR, "attempt to convert mat(%zux%zu) to mat(%zux%zu)", src.rows, src.cols, dst->rows, dst->cols);
+    for(size_t i = 0; i < src.rows*src.cols; i++) dst->mat[i] = (float)src.mat[i];
+    return LINALG_OK;
+}
+
+// columns factored together by mat2DFLUFactor, the trailing update then streams each row once per block
+#define LA_LU_BLOCK 64
+
+// y -= a * x, x and y do not overlap
+static void luAxpyF(float a, const float* restrict x, float* restrict y, size_t n)
+{
+    for(size_t j = 0; j < n; j++) y[j] -= a * x[j];
+}
+
+// LU factorize A in single precision(partial pivoting)
+// at step k, row k was swapped with row order[k] (so order can be applied in place to a rhs)
+// blocked right looking: a panel of LA_LU_BLOCK columns is factored, then the rows right of it
+// are solved for U and the trailing matrix gets one rank LA_LU_BLOCK update
+int mat2DFLUFactor(Mat2d A, Mat2dF* lu, size_t* order)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
+    LINALG_ASSERT_ERROR(A.rows != A.cols, LINALG_ERROR, "invalid operation: LU factorization of non square matrix mat(%zux%zu)", A.rows, A.cols);
+    LINALG_ASSERT_ERROR(mat2DToF(A, lu) != LINALG_OK, LINALG_ERROR, "invalid LU storage!");
+
+    size_t n = A.rows;
+    float* a = lu->mat;
+
+    for(size_t kb = 0; kb < n; kb += LA_LU_BLOCK)
+    {
+        size_t ke = kb + LA_LU_BLOCK < n ? kb + LA_LU_BLOCK : n;
+
+        // panel factorization, columns [kb, ke)
+        for(size_t k = kb; k < ke; k++)
+        {
+            size_t p = k;
+            float maxval = fabsf(a[k * n + k]);
+            for(size_t i = k + 1; i < n; i++)
+            {
+                if(fabsf(a[i * n + k]) > maxval)
+                {
+                    maxval = fabsf(a[i * n + k]);
+                    p = i;
+                }
+            }
+            LINALG_ASSERT_ERROR(maxval == 0, LINALG_ERROR, "matrix is singular(in single precision) at column %zu!", k);
+
+            order[k] = p;
+            if(p != k)
+            {
+                for(size_t j = 0; j < n; j++)
+                {
+                    float tmp = a[k * n + j];
+                    a[k * n + j] = a[p * n + j];
+                    a[p * n + j] = tmp;
+                }
+            }
+
+            float inv = 1.0f / a[k * n + k];
+            for(size_t i = k + 1; i < n; i++)
+            {
+                float l = a[i * n + k] * inv;
+                a[i * n + k] = l;
+                luAxpyF(l, a + k * n + k + 1, a + i * n + k + 1, ke - k - 1);
+            }
+        }
+
+        if(ke == n) break;
+
+        // U12 = L11^-1 A12
+        for(size_t i = kb + 1; i < ke; i++)
+        {
+            for(size_t k = kb; k < i; k++) luAxpyF(a[i * n + k], a + k * n + ke, a + i * n + ke, n - ke);
+        }
+
+        // A22 -= L21 U12, the row segment of A22 stays in cache for the whole block
+        for(size_t i = ke; i < n; i++)
+        {
+            for(size_t k = kb; k < ke; k++) luAxpyF(a[i * n + k], a + k * n + ke, a + i * n + ke, n - ke);
+        }
+    }
+
+    return LINALG_OK;
+}
+// solve LU x = b in single precision using a factorization from mat2DFLUFactor, x holds b on entry
+int mat2DFLUSolve(Mat2dF lu, const size_t* order, VecF* x)
+{
+    LINALG_TRACE_SCOPE(lu.rows, lu.cols, 0);
+    LINALG_ASSERT_ERROR(!x || !x->x || !lu.mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(lu.rows != x->len, LINALG_ERROR, "invalid vector: LU of mat(%zux%zu) applied over vec(%zu)", lu.rows, lu.cols, x->len);
+
+    size_t n = lu.rows;
+    const float* a = lu.mat;
+    float* v = x->x;
+    size_t s = x->offset;
+
+    for(size_t k = 0; k < n; k++)
+    {
+        float tmp = v[k * s];
+        v[k * s] = v[order[k] * s];
+        v[order[k] * s] = tmp;
+    }
+
+    // L has a unit diagonal
+    for(size_t i = 1; i < n; i++)
+    {
+        float sum = v[i * s];
+        for(size_t j = 0; j < i; j++) sum -= a[i * n + j] * v[j * s];
+        v[i * s] = sum;
+    }
+    for(size_t i = n; i-- > 0;)
+    {
+        float sum = v[i * s];
+        for(size_t j = i + 1; j < n; j++) sum -= a[i * n + j] * v[j * s];
+        v[i * s] = sum / a[i * n + i];
+    }
+
+    return LINALG_OK;
+}
+
+// solve Ax = b to double precision, with a single precision factorization and iterative refinement
+int mat2DSqSolveMixed(Mat2d A, Vec b, Mat2dF* lu, size_t* order, VecF* work, Vec* residual, Vec* y)
+{
+    LINALG_TRACE_SCOPE(A.rows, A.cols, 0);
+    LINALG_ASSERT_ERROR(A.rows != A.cols, LINALG_ERROR, "invalid operation: mat2DSq operation on non square matrix mat(%zux%zu)", A.rows, A.cols);
+    LINALG_ASSERT_ERROR(!lu || !work || !residual || !y, LINALG_ERROR, "scratch/result is null!");
+    LINALG_ASSERT_ERROR(b.len != A.rows || y->len != A.rows || residual->len != A.rows || work->len != A.rows, LINALG_ERROR,
+                        "invalid operation: mat(%zux%zu) solve with vec(%zu), result vec(%zu), residual vec(%zu) and work vec(%zu)", A.rows, A.cols, b.len, y->len, residual->len, work->len);
+
+    if(mat2DFLUFactor(A, lu, order) != LINALG_OK) return LINALG_ERROR;
+
+    size_t n = A.rows;
+
+    // ||A||_inf, for the stopping criterion
+    double anorm = 0;
+    for(size_t i = 0; i < n; i++)
+    {
+        double sum = 0;
+        for(size_t j = 0; j < n; j++) sum += fabs(A.mat[i * n + j]);
+        anorm = anorm > sum ? anorm : sum;
+    }
+    double tol = anorm * DBL_EPSILON * sqrt((double)n);
+
+    for(size_t i = 0; i < n; i++) y->x[i * y->offset] = 0;
+
+    // largest residual entry of the current iterate, while it keeps shrinking the current iterate is the best one
+    double best = INFINITY;
+    for(size_t iter = 0; iter <= LA_MIXED_MAX_ITER; iter++)
+    {
+        // residual = b - Ay in double precision
+        vecCopy(b, residual);
+        if(iter > 0) mat2DGemv(-1.0, A, *y, 1.0, residual);
+        double rnorm = vecMaxAbs(*residual);
+
+        // converged when the residual is at the level of the double rounding error of Ay
+        if(iter > 0 && rnorm <= vecMaxAbs(*y) * tol) return LINALG_OK;
+
+        // diverging(or stuck), the last correction made things worse so it's taken back(work still holds it)
+        if(rnorm >= best)
+        {
+            if(rnorm > best)
+                for(size_t i = 0; i < n; i++) y->x[i * y->offset] -= (double)work->x[i * work->offset];
+            break;
+        }
+        best = rnorm;
+        if(iter == LA_MIXED_MAX_ITER) break;
+
+        // correction is solved in single precision
+        vecToF(*residual, work);
+        mat2DFLUSolve(*lu, order, work);
+        for(size_t i = 0; i < n; i++) y->x[i * y->offset] += (double)work->x[i * work->offset];
+    }
+
+    LINALG_REPORT_WARN("mixed precision refinement did not converge(stopped after at most %d iterations), use mat2DSqSolve instead!", LA_MIXED_MAX_ITER);
+    return LINALG_ERROR;
+}
+
+// free the vector on the heap
+void freeVecF(VecF* vec)
+{
+    if(!vec->x) return;
+
+    free(vec->x);
+    vec->x = NULL;
+    vec->len = 0;
+}
+// free the matrix on the heap
+void freeMat2DF(Mat2dF* mat)
+{
+    if(!mat->mat) return;
+
+    free(mat->mat);
+    mat->mat = NULL;
+    mat->rows = 0;
+    mat->cols = 0;
+}
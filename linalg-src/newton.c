@@ -0,0 +1,164 @@
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+
+// sufficient decrease of the residual norm for the line search, ||F(x + l dx)|| <= (1 - alpha l) ||F(x)||
+#define LA_NEWTON_ARMIJO 1e-4
+
+static double newtonNorm(const Vec2* v, size_t n)
+{
+    double sum = 0.0;
+    for(size_t i = 0; i < n; i++) sum += v[i].x[0] * v[i].x[0] + v[i].x[1] * v[i].x[1];
+    return sqrt(sum);
+}
+
+// trial = x + damping * dx
+static void newtonAxpy(double damping, const Vec2* dx, const Vec2* x, Vec2* trial, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        trial[i].x[0] = x[i].x[0] + damping * dx[i].x[0];
+        trial[i].x[1] = x[i].x[1] + damping * dx[i].x[1];
+    }
+}
+
+// default options: Shamanskii with a factorization reused for 3 iterations, damping down to 1/1024
+BlkNewtonOptions blkNewtonDefaultOptions()
+{
+    BlkNewtonOptions opts;
+    opts.max_iter = 50;
+    opts.atol = 1e-10;
+    opts.rtol = 1e-10;
+    opts.step_tol = 1e-14;
+    opts.reuse = 3;
+    opts.contraction = 0.5;
+    opts.min_damping = 1.0 / 1024.0;
+    opts.monitor = NULL;
+    opts.monitor_user = NULL;
+    return opts;
+}
+
+// refactor J at x, returns LINALG_ERROR if the jacobian callback fails
+static int newtonRefactor(BlkNewtonJacobianFn jacobian, void* user, const Vec2* x, MatBlock2TD* J, BlkNewtonResult* result)
+{
+    LINALG_ASSERT_ERROR(jacobian(user, x, J) != LINALG_OK, LINALG_ERROR, "jacobian callback failed at iteration %zu!", result->iterations);
+    blkTriDiagFactorSelf(J);
+    result->factorizations++;
+    return LINALG_OK;
+}
+
+// solve F(x) = 0 with damped newton iterations on the block tridiagonal jacobian J(n = J->len blocks)
+// the factorization of J is reused for opts.reuse iterations(1 is plain newton, 0 is the chord method) and
+// refactored early when the residual norm contracts by less than opts.contraction or the line search fails on a stale one
+// stops once ||F|| <= atol + rtol ||F(x0)|| or the step is below step_tol relative to ||x||
+// x holds the initial guess on entry and the last iterate on exit, work should be 4n elements big
+// returns LINALG_ERROR if a callback fails, the line search fails on a fresh factorization or max_iter is reached
+int blkTriDiagNewton(BlkNewtonResidualFn residual, BlkNewtonJacobianFn jacobian, void* user,
+                     Vec2* x, MatBlock2TD* J, Vec2* work, BlkNewtonOptions opts, BlkNewtonResult* result)
+{
+    LINALG_TRACE_SCOPE(J ? J->len : 0, opts.reuse, 0);
+    LINALG_ASSERT_ERROR(!residual || !jacobian, LINALG_ERROR, "newton needs residual and jacobian callbacks!");
+    LINALG_ASSERT_ERROR(!x || !J || !work, LINALG_ERROR, "newton state, jacobian or scratch space is null!");
+
+    size_t n = J->len;
+    Vec2* F = work;
+    Vec2* dx = work + n;
+    Vec2* trial = work + 2 * n;
+    Vec2* trial_F = work + 3 * n;
+
+    BlkNewtonResult res = { 0, 0, 0.0, 0 };
+    int status = LINALG_OK;
+
+    if(residual(user, x, F) != LINALG_OK)
+    {
+        LINALG_REPORT_ERROR("residual callback failed at the initial guess!");
+        if(result) *result = res;
+        return LINALG_ERROR;
+    }
+    double norm = newtonNorm(F, n);
+    double tol = opts.atol + opts.rtol * norm;
+    res.residual_norm = norm;
+
+    // iterations the current factorization has been used for, -1 if there is none
+    long age = -1;
+    while(norm > tol)
+    {
+        if(res.iterations >= opts.max_iter)
+        {
+            LINALG_REPORT_ERROR("newton did not converge in %zu iterations(residual %g)!", opts.max_iter, norm);
+            status = LINALG_ERROR;
+            break;
+        }
+
+        int refactored = 0;
+        if(age < 0 || (opts.reuse > 0 && (size_t)age >= opts.reuse))
+        {
+            if(newtonRefactor(jacobian, user, x, J, &res) != LINALG_OK)
+            {
+                status = LINALG_ERROR;
+                break;
+            }
+            age = 0;
+            refactored = 1;
+        }
+
+        for(size_t i = 0; i < n; i++)
+        {
+            dx[i].x[0] = -F[i].x[0];
+            dx[i].x[1] = -F[i].x[1];
+        }
+        blkTriDiagFactorSolve(*J, dx);
+
+        // backtrack until the residual norm decreases enough
+        double damping = 1.0, trial_norm = INFINITY;
+        while(damping >= opts.min_damping)
+        {
+            newtonAxpy(damping, dx, x, trial, n);
+            trial_norm = residual(user, trial, trial_F) == LINALG_OK ? newtonNorm(trial_F, n) : INFINITY;
+            if(trial_norm <= (1.0 - LA_NEWTON_ARMIJO * damping) * norm) break;
+            damping *= 0.5;
+        }
+
+        if(damping < opts.min_damping)
+        {
+            // a stale jacobian may just give a poor direction, retry this iteration with a fresh one
+            if(!refactored)
+            {
+                age = -1;
+                continue;
+            }
+            LINALG_REPORT_ERROR("newton line search failed at iteration %zu(residual %g)!", res.iterations, norm);
+            status = LINALG_ERROR;
+            break;
+        }
+
+        // accept the step
+        memcpy(x, trial, n * sizeof(Vec2));
+        Vec2* tmp = F;
+        F = trial_F;
+        trial_F = tmp;
+
+        double step_norm = damping * newtonNorm(dx, n);
+        // slow contraction, the reused factorization is no longer good enough
+        if(trial_norm > opts.contraction * norm) age = -1;
+        else age++;
+
+        norm = trial_norm;
+        res.iterations++;
+        res.residual_norm = norm;
+
+        if(opts.monitor)
+        {
+            BlkNewtonIter iter = { res.iterations, norm, step_norm, damping, refactored, x, F, n };
+            opts.monitor(opts.monitor_user, &iter);
+        }
+
+        if(step_norm <= opts.step_tol * (newtonNorm(x, n) + opts.step_tol)) break;
+    }
+
+    res.converged = status == LINALG_OK;
+    if(result) *result = res;
+    return status;
+}
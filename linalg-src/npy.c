@@ -0,0 +1,431 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <stdint.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define LA_NPY_MMAP 1
+#endif
+
+// .npy format(version 1.0): magic, version, header length(uint16 little endian), python dict header padded with spaces and '\n'
+// the data follows the header, numpy pads the header so the data starts on a 64 byte boundary
+#define LA_NPY_MAGIC "\x93NUMPY"
+#define LA_NPY_MAGIC_LEN 6
+#define LA_NPY_ALIGN 64
+// elements written per fwrite for strided vectors
+#define LA_NPY_CHUNK 4096
+
+typedef struct NpyHeader
+{
+    // 1 or 2 dimensions
+    int ndim;
+    size_t rows;
+    size_t cols;
+    int fortran_order;
+    // offset of the data from the start of the file
+    size_t data_offset;
+} NpyHeader;
+
+// '<f8' or '>f8', whichever is the native double
+static const char* npyDescr()
+{
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1 ? "<f8" : ">f8";
+}
+
+// write the magic string and a header describing rows x cols doubles(1 dimensional if ndim is 1)
+static int npyWriteHeader(FILE* file, int ndim, size_t rows, size_t cols)
+{
+    char dict[256];
+    int len;
+    if(ndim == 1) len = snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%zu,), }", npyDescr(), rows);
+    else len = snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%zu, %zu), }", npyDescr(), rows, cols);
+
+    // pad with spaces up to a '\n' at the alignment boundary
+    size_t prefix = LA_NPY_MAGIC_LEN + 2 + 2;
+    size_t total = (prefix + (size_t)len + 1 + LA_NPY_ALIGN - 1) / LA_NPY_ALIGN * LA_NPY_ALIGN;
+    size_t hlen = total - prefix;
+
+    uint8_t pre[LA_NPY_MAGIC_LEN + 4];
+    memcpy(pre, LA_NPY_MAGIC, LA_NPY_MAGIC_LEN);
+    pre[6] = 1;
+    pre[7] = 0;
+    pre[8] = (uint8_t)(hlen & 0xff);
+    pre[9] = (uint8_t)(hlen >> 8);
+
+    if(fwrite(pre, 1, sizeof(pre), file) != sizeof(pre)) return LINALG_ERROR;
+    if(fwrite(dict, 1, (size_t)len, file) != (size_t)len) return LINALG_ERROR;
+    for(size_t i = (size_t)len; i + 1 < hlen; i++) fputc(' ', file);
+    fputc('\n', file);
+    return ferror(file) ? LINALG_ERROR : LINALG_OK;
+}
+
+// value following key in a header dict, NULL if the key is missing
+static const char* npyFindKey(const char* dict, size_t len, const char* key)
+{
+    size_t klen = strlen(key);
+    for(size_t i = 0; i + klen <= len; i++)
+    {
+        if(memcmp(dict + i, key, klen) != 0) continue;
+
+        const char* p = dict + i + klen;
+        while(p < dict + len && (*p == ' ' || *p == ':')) p++;
+        return p;
+    }
+    return NULL;
+}
+
+// parse the magic string and header at the start of buf(len bytes)
+// returns LINALG_ERROR if the file is not a native double .npy with at most 2 dimensions
+static int npyParseHeader(const uint8_t* buf, size_t len, NpyHeader* header)
+{
+    LINALG_ASSERT_ERROR(len < LA_NPY_MAGIC_LEN + 4 || memcmp(buf, LA_NPY_MAGIC, LA_NPY_MAGIC_LEN) != 0, LINALG_ERROR, "not a .npy file(bad magic string)!");
+    LINALG_ASSERT_ERROR(buf[6] < 1 || buf[6] > 3, LINALG_ERROR, "unsupported .npy version %d.%d!", buf[6], buf[7]);
+
+    // version 1 has a 2 byte header length, versions 2 and 3 a 4 byte one
+    size_t hlen, prefix;
+    if(buf[6] == 1)
+    {
+        hlen = (size_t)buf[8] | (size_t)buf[9] << 8;
+        prefix = LA_NPY_MAGIC_LEN + 4;
+    }
+    else
+    {
+        LINALG_ASSERT_ERROR(len < LA_NPY_MAGIC_LEN + 6, LINALG_ERROR, "truncated .npy header!");
+        hlen = (size_t)buf[8] | (size_t)buf[9] << 8 | (size_t)buf[10] << 16 | (size_t)buf[11] << 24;
+        prefix = LA_NPY_MAGIC_LEN + 6;
+    }
+    LINALG_ASSERT_ERROR(prefix + hlen > len, LINALG_ERROR, "truncated .npy header!");
+
+    const char* dict = (const char*)buf + prefix;
+
+    const char* descr = npyFindKey(dict, hlen, "'descr'");
+    LINALG_ASSERT_ERROR(!descr || descr + 5 > dict + hlen, LINALG_ERROR, "missing descr in .npy header!");
+    const char* native = npyDescr();
+    int is_native = memcmp(descr + 1, native, 3) == 0 || (memcmp(descr + 1, "=f8", 3) == 0);
+    LINALG_ASSERT_ERROR(!is_native || descr[4] != descr[0], LINALG_ERROR, "unsupported .npy dtype %.5s(only native doubles %s are supported)!", descr, native);
+
+    const char* order = npyFindKey(dict, hlen, "'fortran_order'");
+    LINALG_ASSERT_ERROR(!order, LINALG_ERROR, "missing fortran_order in .npy header!");
+    header->fortran_order = *order == 'T';
+
+    const char* shape = npyFindKey(dict, hlen, "'shape'");
+    LINALG_ASSERT_ERROR(!shape || *shape != '(', LINALG_ERROR, "missing shape in .npy header!");
+
+    size_t dims[2] = { 1, 1 };
+    int ndim = 0;
+    const char* p = shape + 1;
+    while(p < dict + hlen && *p != ')')
+    {
+        if(*p < '0' || *p > '9')
+        {
+            p++;
+            continue;
+        }
+        LINALG_ASSERT_ERROR(ndim == 2, LINALG_ERROR, "unsupported .npy shape(more than 2 dimensions)!");
+
+        char* end;
+        dims[ndim++] = strtoull(p, &end, 10);
+        p = end;
+    }
+    LINALG_ASSERT_ERROR(ndim == 0, LINALG_ERROR, "unsupported .npy shape(0 dimensional)!");
+    LINALG_ASSERT_ERROR(dims[1] != 0 && dims[0] > SIZE_MAX / sizeof(double) / dims[1], LINALG_ERROR, ".npy shape (%zu, %zu) is too big!", dims[0], dims[1]);
+
+    header->ndim = ndim;
+    header->rows = dims[0];
+    header->cols = dims[1];
+    header->data_offset = prefix + hlen;
+    return LINALG_OK;
+}
+
+// the shape as a vector length, any 1 dimensional or single row/col array
+static int npyVecLen(NpyHeader header, size_t* len)
+{
+    LINALG_ASSERT_ERROR(header.ndim == 2 && header.rows != 1 && header.cols != 1, LINALG_ERROR, "can't load .npy of shape (%zu, %zu) as a vector!", header.rows, header.cols);
+    *len = header.rows * header.cols;
+    return LINALG_OK;
+}
+
+// save a vector as a 1 dimensional .npy file
+int vecSaveNpy(Vec a, const char* path)
+{
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
+    LINALG_ASSERT_ERROR(!a.x || !path, LINALG_ERROR, "input vector/path is null!");
+
+    FILE* file = fopen(path, "wb");
+    LINALG_ASSERT_ERROR(!file, LINALG_ERROR, "could not open %s for writing!", path);
+
+    int status = npyWriteHeader(file, 1, a.len, 1);
+    if(status == LINALG_OK && a.offset == 1) status = fwrite(a.x, sizeof(double), a.len, file) == a.len ? LINALG_OK : LINALG_ERROR;
+    else if(status == LINALG_OK)
+    {
+        // gather strided elements chunk by chunk
+        double chunk[LA_NPY_CHUNK];
+        for(size_t i = 0; i < a.len && status == LINALG_OK; i += LA_NPY_CHUNK)
+        {
+            size_t count = a.len - i < LA_NPY_CHUNK ? a.len - i : LA_NPY_CHUNK;
+            for(size_t j = 0; j < count; j++) chunk[j] = a.x[(i + j) * a.offset];
+            status = fwrite(chunk, sizeof(double), count, file) == count ? LINALG_OK : LINALG_ERROR;
+        }
+    }
+
+    fclose(file);
+    LINALG_ASSERT_ERROR(status != LINALG_OK, LINALG_ERROR, "failed writing %s!", path);
+    return LINALG_OK;
+}
+// save a matrix as a 2 dimensional(C order) .npy file
+int mat2DSaveNpy(Mat2d a, const char* path)
+{
+    LINALG_TRACE_SCOPE(a.rows, a.cols, 0);
+    LINALG_ASSERT_ERROR(!a.mat || !path, LINALG_ERROR, "input matrix/path is null!");
+
+    FILE* file = fopen(path, "wb");
+    LINALG_ASSERT_ERROR(!file, LINALG_ERROR, "could not open %s for writing!", path);
+
+    int status = npyWriteHeader(file, 2, a.rows, a.cols);
+    if(status == LINALG_OK) status = fwrite(a.mat, sizeof(double), a.rows * a.cols, file) == a.rows * a.cols ? LINALG_OK : LINALG_ERROR;
+
+    fclose(file);
+    LINALG_ASSERT_ERROR(status != LINALG_OK, LINALG_ERROR, "failed writing %s!", path);
+    return LINALG_OK;
+}
+
+// create a rowsxcols .npy file of zeros without writing the data(sparse where the filesystem supports it),
+// made to be mapped with mat2DLoadNpyMap(LINALG_MAP_SHARED) as the result of an out of core computation
+int mat2DCreateNpy(const char* path, size_t rows, size_t cols)
+{
+    LINALG_TRACE_SCOPE(rows, cols, 0);
+    LINALG_ASSERT_ERROR(!path, LINALG_ERROR, "path is null!");
+    LINALG_ASSERT_ERROR(cols != 0 && rows > SIZE_MAX / sizeof(double) / cols, LINALG_ERROR, "mat(%zux%zu) is too big for %s!", rows, cols, path);
+
+    FILE* file = fopen(path, "wb");
+    LINALG_ASSERT_ERROR(!file, LINALG_ERROR, "could not open %s for writing!", path);
+
+    int status = npyWriteHeader(file, 2, rows, cols);
+    // seek to the last byte of the data and write it, the hole before it reads as zeros
+    if(status == LINALG_OK && rows * cols > 0)
+    {
+#ifdef LA_NPY_MMAP
+        int seeked = fseeko(file, (off_t)(rows * cols * sizeof(double) - 1), SEEK_CUR) == 0;
+#else
+        int seeked = fseek(file, (long)(rows * cols * sizeof(double) - 1), SEEK_CUR) == 0;
+#endif
+        status = seeked && fputc(0, file) != EOF ? LINALG_OK : LINALG_ERROR;
+    }
+
+    if(fclose(file) != 0) status = LINALG_ERROR;
+    LINALG_ASSERT_ERROR(status != LINALG_OK, LINALG_ERROR, "failed writing %s!", path);
+    return LINALG_OK;
+}
+
+// read the header of a .npy file, file is left at the start of the data
+static int npyReadHeader(FILE* file, const char* path, NpyHeader* header)
+{
+    uint8_t pre[LA_NPY_MAGIC_LEN + 6];
+    LINALG_ASSERT_ERROR(fread(pre, 1, sizeof(pre), file) != sizeof(pre), LINALG_ERROR, "%s is too short for a .npy file!", path);
+    LINALG_ASSERT_ERROR(memcmp(pre, LA_NPY_MAGIC, LA_NPY_MAGIC_LEN) != 0, LINALG_ERROR, "%s is not a .npy file(bad magic string)!", path);
+    LINALG_ASSERT_ERROR(pre[6] < 1 || pre[6] > 3, LINALG_ERROR, "%s has unsupported .npy version %d.%d!", path, pre[6], pre[7]);
+
+    size_t hlen = pre[6] == 1 ? ((size_t)pre[8] | (size_t)pre[9] << 8) + LA_NPY_MAGIC_LEN + 4
+                              : ((size_t)pre[8] | (size_t)pre[9] << 8 | (size_t)pre[10] << 16 | (size_t)pre[11] << 24) + LA_NPY_MAGIC_LEN + 6;
+
+    // the header length comes from the file, it has to cover what was already read
+    LINALG_ASSERT_ERROR(hlen < sizeof(pre), LINALG_ERROR, "%s has a truncated .npy header!", path);
+
+    uint8_t* buf = malloc(hlen);
+    LINALG_ASSERT_ERROR(!buf, LINALG_ERROR, "unkown error occured when allocation memory!");
+    memcpy(buf, pre, sizeof(pre));
+
+    int status = fread(buf + sizeof(pre), 1, hlen - sizeof(pre), file) == hlen - sizeof(pre) ? npyParseHeader(buf, hlen, header) : LINALG_ERROR;
+    free(buf);
+    return status;
+}
+
+// read rows * cols doubles following the header, transposing fortran order data
+static int npyReadData(FILE* file, NpyHeader header, double* data)
+{
+    size_t count = header.rows * header.cols;
+    if(fread(data, sizeof(double), count, file) != count) return LINALG_ERROR;
+    if(!header.fortran_order || header.ndim == 1) return LINALG_OK;
+
+    double* tmp = malloc(count * sizeof(double));
+    LINALG_ASSERT_ERROR(!tmp, LINALG_ERROR, "unkown error occured when allocation memory!");
+    memcpy(tmp, data, count * sizeof(double));
+    for(size_t i = 0; i < header.rows; i++)
+    {
+        for(size_t j = 0; j < header.cols; j++) data[i * header.cols + j] = tmp[j * header.rows + i];
+    }
+    free(tmp);
+    return LINALG_OK;
+}
+
+// load a .npy file into a vector on the heap
+Vec vecLoadNpyA(const char* path)
+{
+    LINALG_TRACE_SCOPE(0, 0, 0);
+    FILE* file = fopen(path, "rb");
+    LINALG_ASSERT_ERROR(!file, nullVec, "could not open %s for reading!", path);
+
+    NpyHeader header;
+    size_t len;
+    if(npyReadHeader(file, path, &header) != LINALG_OK || npyVecLen(header, &len) != LINALG_OK)
+    {
+        fclose(file);
+        return nullVec;
+    }
+
+    Vec x = vecInitZerosA(len);
+    if(x.x && npyReadData(file, header, x.x) != LINALG_OK)
+    {
+        LINALG_REPORT_ERROR("failed reading data from %s!", path);
+        freeVec(&x);
+        x = nullVec;
+    }
+    fclose(file);
+    return x;
+}
+// load a .npy file into a matrix on the heap(1 dimensional files load as a single row)
+Mat2d mat2DLoadNpyA(const char* path)
+{
+    LINALG_TRACE_SCOPE(0, 0, 0);
+    FILE* file = fopen(path, "rb");
+    LINALG_ASSERT_ERROR(!file, ((Mat2d){ NULL, 0, 0 }), "could not open %s for reading!", path);
+
+    NpyHeader header;
+    if(npyReadHeader(file, path, &header) != LINALG_OK)
+    {
+        fclose(file);
+        return (Mat2d){ NULL, 0, 0 };
+    }
+    if(header.ndim == 1)
+    {
+        header.cols = header.rows;
+        header.rows = 1;
+    }
+
+    Mat2d mat = mat2DInitZerosA(header.rows, header.cols);
+    if(mat.mat && npyReadData(file, header, mat.mat) != LINALG_OK)
+    {
+        LINALG_REPORT_ERROR("failed reading data from %s!", path);
+        freeMat2D(&mat);
+        mat = (Mat2d){ NULL, 0, 0 };
+    }
+    fclose(file);
+    return mat;
+}
+
+// map a whole .npy file and parse its header
+static double* npyMap(const char* path, int mode, LinalgMap* map, NpyHeader* header)
+{
+    LINALG_ASSERT_ERROR(!path || !map, NULL, "input path/map is null!");
+    *map = (LinalgMap){ NULL, 0 };
+
+#ifdef LA_NPY_MMAP
+    int fd = open(path, mode == LINALG_MAP_SHARED ? O_RDWR : O_RDONLY);
+    LINALG_ASSERT_ERROR(fd < 0, NULL, "could not open %s for mapping!", path);
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        LINALG_REPORT_ERROR("could not stat %s(or it is empty)!", path);
+        return NULL;
+    }
+
+    // private mappings are copy on write, so the view is writable either way
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, mode == LINALG_MAP_SHARED ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    close(fd);
+    LINALG_ASSERT_ERROR(base == MAP_FAILED, NULL, "mmap of %s failed!", path);
+
+    *map = (LinalgMap){ base, (size_t)st.st_size };
+#else
+    (void)mode;
+    // no mmap on this platform, fall back to reading the whole file
+    FILE* file = fopen(path, "rb");
+    LINALG_ASSERT_ERROR(!file, NULL, "could not open %s for reading!", path);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    void* base = size > 0 ? malloc((size_t)size) : NULL;
+    if(!base || fread(base, 1, (size_t)size, file) != (size_t)size)
+    {
+        free(base);
+        fclose(file);
+        LINALG_REPORT_ERROR("failed reading %s!", path);
+        return NULL;
+    }
+    fclose(file);
+    *map = (LinalgMap){ base, (size_t)size };
+#endif
+
+    if(npyParseHeader(map->base, map->size, header) != LINALG_OK)
+    {
+        freeLinalgMap(map);
+        return NULL;
+    }
+    if(header->fortran_order && header->ndim == 2 && header->rows > 1 && header->cols > 1)
+    {
+        LINALG_REPORT_ERROR("%s is fortran ordered and can't be viewed without a copy, use mat2DLoadNpyA!", path);
+        freeLinalgMap(map);
+        return NULL;
+    }
+    // npyParseHeader keeps data_offset within the file and the data size from overflowing
+    if(header->rows * header->cols * sizeof(double) > map->size - header->data_offset || header->data_offset % sizeof(double) != 0)
+    {
+        LINALG_REPORT_ERROR("%s is truncated or misaligned!", path);
+        freeLinalgMap(map);
+        return NULL;
+    }
+
+    return (double*)((uint8_t*)map->base + header->data_offset);
+}
+
+// map a .npy file and view it as a vector(zero copy), pages are read on first access
+Vec vecLoadNpyMap(const char* path, int mode, LinalgMap* map)
+{
+    LINALG_TRACE_SCOPE(mode, 0, 0);
+    NpyHeader header;
+    size_t len;
+    double* data = npyMap(path, mode, map, &header);
+    if(!data) return nullVec;
+    if(npyVecLen(header, &len) != LINALG_OK)
+    {
+        freeLinalgMap(map);
+        return nullVec;
+    }
+    return vecConstruct(data, len);
+}
+// map a .npy file and view it as a matrix(zero copy), pages are read on first access
+Mat2d mat2DLoadNpyMap(const char* path, int mode, LinalgMap* map)
+{
+    LINALG_TRACE_SCOPE(mode, 0, 0);
+    NpyHeader header;
+    double* data = npyMap(path, mode, map, &header);
+    if(!data) return (Mat2d){ NULL, 0, 0 };
+    if(header.ndim == 1) return mat2DConstruct(data, 1, header.rows);
+    return mat2DConstruct(data, header.rows, header.cols);
+}
+
+// unmap a file, every view into it is invalid after this
+void freeLinalgMap(LinalgMap* map)
+{
+    if(!map->base) return;
+
+#ifdef LA_NPY_MMAP
+    munmap(map->base, map->size);
+#else
+    free(map->base);
+#endif
+    map->base = NULL;
+    map->size = 0;
+}
@@ -0,0 +1,406 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/mman.h>
+
+// polls of the job counter before a idle worker(or the waiting caller) sleeps
+// keeps back to back parallel fors cheap without burning a core between bursts
+#define LA_CTX_SPIN 4096
+// scratch buffers are aligned(and padded) to cache lines
+#define LA_CTX_CACHE_LINE 64
+
+// per thread state, padded so the cursors of different threads never share a cache line
+typedef struct LinalgCtxSlot
+{
+    // next index of this thread's range, threads that run out of work steal from it too
+    _Alignas(LA_CTX_CACHE_LINE) atomic_size_t next;
+    size_t end;
+
+    void* scratch;
+    size_t scratch_size;
+} LinalgCtxSlot;
+
+typedef struct LinalgCtxWorker
+{
+    struct LinalgCtx* ctx;
+    size_t index;
+} LinalgCtxWorker;
+
+struct LinalgCtx
+{
+    size_t threads;
+    // polls before sleeping, 0 when there are more threads than cpus(spinning would only steal time from the workers)
+    size_t spin;
+    pthread_t* workers;
+    LinalgCtxWorker* worker_args;
+    LinalgCtxSlot* slots;
+
+    // one parallel for at a time
+    pthread_mutex_t run;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+
+    // current job
+    LinalgRangeFn fn;
+    void* args;
+    size_t grain;
+
+    // bumped once per job, workers wait for it to change
+    atomic_size_t generation;
+    // workers that have not finished the current job
+    atomic_size_t pending;
+    atomic_int shutdown;
+};
+
+// index of the calling thread in its pool, nested parallel fors run inline on it
+static _Thread_local size_t la_ctx_thread = 0;
+static _Thread_local int la_ctx_in_pool = 0;
+
+static inline void ctxRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// pin the calling thread to a cpu, does nothing on platforms without affinity
+static void ctxPin(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    {
+        LINALG_REPORT_WARN("could not pin thread to cpu %d!", cpu);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+// run chunks of the current job, own range first and then steal from the others
+static void ctxRun(LinalgCtx* ctx, size_t self)
+{
+    // one event per thread and job, so stragglers show up on the timeline
+    LINALG_TRACE_SCOPE(self, ctx->grain, 0);
+    for(size_t v = 0; v < ctx->threads; v++)
+    {
+        LinalgCtxSlot* slot = &ctx->slots[(self + v) % ctx->threads];
+        while(1)
+        {
+            size_t begin = atomic_fetch_add_explicit(&slot->next, ctx->grain, memory_order_relaxed);
+            if(begin >= slot->end) break;
+
+            size_t end = begin + ctx->grain < slot->end ? begin + ctx->grain : slot->end;
+            ctx->fn(ctx->args, begin, end, self);
+        }
+    }
+}
+
+static void* ctxWorkerMain(void* data)
+{
+    LinalgCtxWorker* worker = data;
+    LinalgCtx* ctx = worker->ctx;
+    la_ctx_thread = worker->index;
+    la_ctx_in_pool = 1;
+
+    size_t seen = 0;
+    while(1)
+    {
+        size_t gen = atomic_load(&ctx->generation);
+        for(size_t spin = 0; gen == seen && spin < ctx->spin && !atomic_load(&ctx->shutdown); spin++)
+        {
+            ctxRelax();
+            gen = atomic_load(&ctx->generation);
+        }
+        if(gen == seen)
+        {
+            pthread_mutex_lock(&ctx->lock);
+            while((gen = atomic_load(&ctx->generation)) == seen && !atomic_load(&ctx->shutdown)) pthread_cond_wait(&ctx->wake, &ctx->lock);
+            pthread_mutex_unlock(&ctx->lock);
+        }
+        if(atomic_load(&ctx->shutdown)) break;
+        seen = gen;
+
+        ctxRun(ctx, worker->index);
+
+        if(atomic_fetch_sub(&ctx->pending, 1) == 1)
+        {
+            pthread_mutex_lock(&ctx->lock);
+            pthread_cond_signal(&ctx->done);
+            pthread_mutex_unlock(&ctx->lock);
+        }
+    }
+    return NULL;
+}
+
+// make a context with a pool of threads(0 for one per online cpu), the calling thread is thread 0
+LinalgCtx* linalgCtxInitA(size_t threads, const int* cpus)
+{
+    LINALG_TRACE_SCOPE(threads, 0, 0);
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t cores = online > 0 ? (size_t)online : 1;
+    if(threads == 0) threads = cores;
+
+    LinalgCtx* ctx = calloc(1, sizeof(LinalgCtx));
+    LINALG_ASSERT_ERROR(!ctx, NULL, "unkown error occured when allocation memory!");
+
+    ctx->threads = threads;
+    ctx->spin = threads <= cores ? LA_CTX_SPIN : 0;
+    ctx->slots = aligned_alloc(LA_CTX_CACHE_LINE, threads * sizeof(LinalgCtxSlot));
+    ctx->workers = calloc(threads, sizeof(pthread_t));
+    ctx->worker_args = calloc(threads, sizeof(LinalgCtxWorker));
+    if(!ctx->slots || !ctx->workers || !ctx->worker_args)
+    {
+        free(ctx->slots);
+        free(ctx->workers);
+        free(ctx->worker_args);
+        free(ctx);
+        LINALG_REPORT_ERROR("unkown error occured when allocation memory!");
+        return NULL;
+    }
+
+    for(size_t t = 0; t < threads; t++)
+    {
+        atomic_init(&ctx->slots[t].next, 0);
+        ctx->slots[t].end = 0;
+        ctx->slots[t].scratch = NULL;
+        ctx->slots[t].scratch_size = 0;
+    }
+
+    pthread_mutex_init(&ctx->run, NULL);
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_cond_init(&ctx->wake, NULL);
+    pthread_cond_init(&ctx->done, NULL);
+    atomic_init(&ctx->generation, 0);
+    atomic_init(&ctx->pending, 0);
+    atomic_init(&ctx->shutdown, 0);
+
+    if(cpus) ctxPin(cpus[0]);
+
+    for(size_t t = 1; t < threads; t++)
+    {
+        ctx->worker_args[t] = (LinalgCtxWorker){ ctx, t };
+        if(pthread_create(&ctx->workers[t], NULL, ctxWorkerMain, &ctx->worker_args[t]) != 0)
+        {
+            // run with the threads we got
+            LINALG_REPORT_WARN("could only start %zu of %zu threads!", t, threads);
+            ctx->threads = t;
+            break;
+        }
+        if(cpus)
+        {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[t], &set);
+            if(pthread_setaffinity_np(ctx->workers[t], sizeof(set), &set) != 0)
+            {
+                LINALG_REPORT_WARN("could not pin thread %zu to cpu %d!", t, cpus[t]);
+            }
+#endif
+        }
+    }
+
+    return ctx;
+}
+
+// number of threads in the context(including the caller)
+size_t linalgCtxThreads(LinalgCtx* ctx)
+{
+    return ctx ? ctx->threads : 1;
+}
+
+// index of the calling thread in the pool running it(0 outside a parallel for)
+size_t linalgCtxThreadIndex()
+{
+    return la_ctx_thread;
+}
+
+// nonzero if the calling thread is running a parallel for(as a worker or as the caller)
+int linalgCtxInPool()
+{
+    return la_ctx_in_pool;
+}
+
+// per thread scratch of at least size bytes(cache line aligned), contents are not kept when it grows
+void* linalgCtxScratch(LinalgCtx* ctx, size_t thread, size_t size)
+{
+    LINALG_ASSERT_ERROR(!ctx || thread >= ctx->threads, NULL, "invalid context/thread %zu!", thread);
+
+    LinalgCtxSlot* slot = &ctx->slots[thread];
+    if(slot->scratch_size >= size) return slot->scratch;
+
+    size = (size + LA_CTX_CACHE_LINE - 1) / LA_CTX_CACHE_LINE * LA_CTX_CACHE_LINE;
+    free(slot->scratch);
+    slot->scratch = aligned_alloc(LA_CTX_CACHE_LINE, size);
+    slot->scratch_size = slot->scratch ? size : 0;
+    LINALG_ASSERT_ERROR(!slot->scratch, NULL, "unkown error occured when allocation memory!");
+    return slot->scratch;
+}
+
+// call fn over [begin, end) in chunks of grain indices, spread over the threads of the context
+void linalgParallelFor(LinalgCtx* ctx, size_t begin, size_t end, size_t grain, LinalgRangeFn fn, void* args)
+{
+    LINALG_TRACE_SCOPE(end - begin, grain, linalgCtxThreads(ctx));
+    if(begin >= end) return;
+    if(grain == 0) grain = 1;
+
+    // inline: no pool, a single chunk, or already inside a parallel for
+    if(!ctx || ctx->threads == 1 || end - begin <= grain || la_ctx_in_pool)
+    {
+        fn(args, begin, end, la_ctx_thread);
+        return;
+    }
+
+    pthread_mutex_lock(&ctx->run);
+    la_ctx_in_pool = 1;
+
+    // contiguous, grain aligned range per thread, so each thread starts on its own memory
+    size_t chunks = (end - begin + grain - 1) / grain;
+    size_t threads = ctx->threads;
+    for(size_t t = 0; t < threads; t++)
+    {
+        size_t c0 = chunks * t / threads, c1 = chunks * (t + 1) / threads;
+        atomic_store_explicit(&ctx->slots[t].next, begin + c0 * grain, memory_order_relaxed);
+        ctx->slots[t].end = begin + c1 * grain < end ? begin + c1 * grain : end;
+    }
+    ctx->fn = fn;
+    ctx->args = args;
+    ctx->grain = grain;
+    atomic_store(&ctx->pending, threads - 1);
+
+    pthread_mutex_lock(&ctx->lock);
+    atomic_fetch_add(&ctx->generation, 1);
+    pthread_cond_broadcast(&ctx->wake);
+    pthread_mutex_unlock(&ctx->lock);
+
+    ctxRun(ctx, 0);
+
+    for(size_t spin = 0; atomic_load(&ctx->pending) > 0 && spin < ctx->spin; spin++) ctxRelax();
+    if(atomic_load(&ctx->pending) > 0)
+    {
+        pthread_mutex_lock(&ctx->lock);
+        while(atomic_load(&ctx->pending) > 0) pthread_cond_wait(&ctx->done, &ctx->lock);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+
+    la_ctx_in_pool = 0;
+    pthread_mutex_unlock(&ctx->run);
+}
+
+typedef struct CtxFillArgs
+{
+    double* x;
+    // elements per index of the parallel for
+    size_t width;
+    double value;
+} CtxFillArgs;
+
+static void ctxFillTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    (void)thread;
+    CtxFillArgs* args = data;
+    double* x = args->x + begin * args->width;
+    size_t count = (end - begin) * args->width;
+
+    if(args->value == 0.0 && !signbit(args->value)) memset(x, 0, count * sizeof(double));
+    else for(size_t i = 0; i < count; i++) x[i] = args->value;
+}
+
+// units * width doubles set to value, written by the threads a parallel for over the units with grain hands them to
+// pages are placed on first write, so they end up on the numa node of the thread that will use them
+static double* ctxAllocFill(LinalgCtx* ctx, double value, size_t units, size_t width, size_t grain)
+{
+    size_t count = units * width;
+    if(count * sizeof(double) < LINALG_HUGE_PAGE)
+    {
+        // too small to matter, calloc memory is already zero
+        double* x = calloc(count, sizeof(double));
+        if(x && (value != 0.0 || signbit(value)))
+            for(size_t i = 0; i < count; i++) x[i] = value;
+        return x;
+    }
+
+    // whole huge pages, freed with free like the others
+    size_t size = (count * sizeof(double) + LINALG_HUGE_PAGE - 1) / LINALG_HUGE_PAGE * LINALG_HUGE_PAGE;
+    double* x = aligned_alloc(LINALG_HUGE_PAGE, size);
+    if(!x) return NULL;
+#ifdef MADV_DONTNEED
+    // malloc may hand back heap pages that were already touched(and placed) by an earlier buffer, even this big.
+    // dropping them makes every page fault in fresh on its first write below, the range is page aligned and all ours
+    madvise(x, size, MADV_DONTNEED);
+#endif
+#ifdef MADV_HUGEPAGE
+    // only a hint, without transparent huge pages(or with them disabled) the buffer keeps normal pages
+    madvise(x, size, MADV_HUGEPAGE);
+#endif
+
+    CtxFillArgs args = { x, width, value };
+    linalgParallelFor(ctx, 0, units, grain, ctxFillTask, &args);
+    return x;
+}
+
+// initialize the vector on the heap for the threads of ctx, placed for the element parallel kernels(vecAddCtx, ...)
+Vec vecInitCtxA(LinalgCtx* ctx, double value, size_t len)
+{
+    LINALG_TRACE_SCOPE(len, linalgCtxThreads(ctx), 0);
+    if(len == 0)
+    {
+        LINALG_REPORT_ERROR("invalid zero length vector requested!");
+        return (Vec){ NULL, 0, 0 };
+    }
+    Vec x = { ctxAllocFill(ctx, value, len, 1, LINALG_CTX_GRAIN(1)), len, 1 };
+    LINALG_ASSERT_ERROR(!x.x, x, "unkown error occured when allocation memory!");
+    return x;
+}
+// initialize the matrix on the heap for the threads of ctx, placed by rows for the row parallel kernels(mat2DMulCtx, ...)
+Mat2d mat2DInitCtxA(LinalgCtx* ctx, double value, size_t rows, size_t cols)
+{
+    LINALG_TRACE_SCOPE(rows, cols, linalgCtxThreads(ctx));
+    if(rows == 0 || cols == 0)
+    {
+        LINALG_REPORT_ERROR("invalid zero row or col matrix requested!");
+        return (Mat2d){ NULL, 0, 0 };
+    }
+    Mat2d mat = { ctxAllocFill(ctx, value, rows, cols, LINALG_CTX_GRAIN(cols)), rows, cols };
+    LINALG_ASSERT_ERROR(!mat.mat, mat, "unkown error occured when allocation memory!");
+    return mat;
+}
+
+// stop the pool and free the context
+void freeLinalgCtx(LinalgCtx* ctx)
+{
+    if(!ctx) return;
+
+    pthread_mutex_lock(&ctx->lock);
+    atomic_store(&ctx->shutdown, 1);
+    pthread_cond_broadcast(&ctx->wake);
+    pthread_mutex_unlock(&ctx->lock);
+
+    for(size_t t = 1; t < ctx->threads; t++) pthread_join(ctx->workers[t], NULL);
+
+    for(size_t t = 0; t < ctx->threads; t++) free(ctx->slots[t].scratch);
+    pthread_mutex_destroy(&ctx->run);
+    pthread_mutex_destroy(&ctx->lock);
+    pthread_cond_destroy(&ctx->wake);
+    pthread_cond_destroy(&ctx->done);
+
+    free(ctx->slots);
+    free(ctx->workers);
+    free(ctx->worker_args);
+    free(ctx);
+}
@@ -0,0 +1,235 @@
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+
+// LINALG_UNPACK_MAT(matrix, r, c)[x][y] = value at xth col and yth row
+#define LA_UNPACK(matrix) ((double (*)[matrix.cols]) matrix.mat)
+
+// householder reflector for column k, rows [k, m) (LAPACK dlarfg)
+// on return a[k][k] = beta, a[i][k] = v_i for i > k(v_k = 1 is implicit), returns tau
+static double qrReflector(Mat2d a, size_t k)
+{
+    double xnorm = 0;
+    for(size_t i = k + 1; i < a.rows; i++) xnorm += LA_UNPACK(a)[i][k] * LA_UNPACK(a)[i][k];
+    if(xnorm == 0) return 0;
+
+    double alpha = LA_UNPACK(a)[k][k];
+    double beta = sqrt(alpha * alpha + xnorm);
+    beta = alpha >= 0 ? -beta : beta;
+
+    double scale = 1.0 / (alpha - beta);
+    for(size_t i = k + 1; i < a.rows; i++) LA_UNPACK(a)[i][k] *= scale;
+    LA_UNPACK(a)[k][k] = beta;
+
+    return (beta - alpha) / beta;
+}
+
+// factor the panel of columns [kb, ke) with single reflectors(LAPACK dgeqr2), w needs ke - kb elements
+static void qrPanel(Mat2d a, size_t kb, size_t ke, Vec* tau, double* w)
+{
+    for(size_t k = kb; k < ke; k++)
+    {
+        double t = qrReflector(a, k);
+        tau->x[k * tau->offset] = t;
+        if(t == 0 || k + 1 == ke) continue;
+
+        // w = A[k:m, k+1:ke]^T v, then A[k:m, k+1:ke] -= tau v w^T, row by row
+        size_t nc = ke - k - 1;
+        memcpy(w, LA_UNPACK(a)[k] + k + 1, nc * sizeof(double));
+        for(size_t i = k + 1; i < a.rows; i++)
+        {
+            double v = LA_UNPACK(a)[i][k];
+            const double* row = LA_UNPACK(a)[i] + k + 1;
+            for(size_t j = 0; j < nc; j++) w[j] += v * row[j];
+        }
+
+        for(size_t j = 0; j < nc; j++) LA_UNPACK(a)[k][k + 1 + j] -= t * w[j];
+        for(size_t i = k + 1; i < a.rows; i++)
+        {
+            double v = t * LA_UNPACK(a)[i][k];
+            double* row = LA_UNPACK(a)[i] + k + 1;
+            for(size_t j = 0; j < nc; j++) row[j] -= v * w[j];
+        }
+    }
+}
+
+// triangular factor of the panel's block reflector, H_kb...H_ke-1 = I - V T V^T (LAPACK dlarft, forward columnwise)
+// T is nb x nb upper triangular with row stride ldt, z needs nb elements
+static void qrPanelT(Mat2d a, size_t kb, size_t ke, Vec tau, double* t, size_t ldt, double* z)
+{
+    size_t nb = ke - kb;
+    for(size_t i = 0; i < nb; i++)
+    {
+        double ti = tau.x[(kb + i) * tau.offset];
+        t[i * ldt + i] = ti;
+        if(i == 0) continue;
+
+        // z = V[:, 0:i]^T v_i, v_i starts at row kb + i with an implicit 1
+        for(size_t j = 0; j < i; j++) z[j] = LA_UNPACK(a)[kb + i][kb + j];
+        for(size_t r = kb + i + 1; r < a.rows; r++)
+        {
+            double vi = LA_UNPACK(a)[r][kb + i];
+            const double* row = LA_UNPACK(a)[r] + kb;
+            for(size_t j = 0; j < i; j++) z[j] += row[j] * vi;
+        }
+
+        // T[0:i, i] = -tau_i T[0:i, 0:i] z
+        for(size_t p = 0; p < i; p++)
+        {
+            double sum = 0;
+            for(size_t q = p; q < i; q++) sum += t[p * ldt + q] * z[q];
+            t[p * ldt + i] = -ti * sum;
+        }
+    }
+}
+
+// C = (I - V T V^T)^T C for the trailing columns [ke, n) (LAPACK dlarfb), w is nb x (n - ke) with row stride ldw
+static void qrApplyBlock(Mat2d a, size_t kb, size_t ke, const double* t, size_t ldt, double* w, size_t ldw)
+{
+    size_t nb = ke - kb, nc = a.cols - ke;
+
+    // W = V^T C, each row of C is streamed once
+    for(size_t p = 0; p < nb; p++) memset(w + p * ldw, 0, nc * sizeof(double));
+    for(size_t r = kb; r < a.rows; r++)
+    {
+        const double* c = LA_UNPACK(a)[r] + ke;
+        size_t pe = r - kb + 1 < nb ? r - kb + 1 : nb;
+        for(size_t p = 0; p < pe; p++)
+        {
+            double v = r == kb + p ? 1.0 : LA_UNPACK(a)[r][kb + p];
+            double* wp = w + p * ldw;
+            for(size_t j = 0; j < nc; j++) wp[j] += v * c[j];
+        }
+    }
+
+    // W = T^T W, bottom up so every row is only read before it is overwritten
+    for(size_t p = nb; p-- > 0;)
+    {
+        double* wp = w + p * ldw;
+        double tpp = t[p * ldt + p];
+        for(size_t j = 0; j < nc; j++) wp[j] *= tpp;
+        for(size_t q = 0; q < p; q++)
+        {
+            double tqp = t[q * ldt + p];
+            const double* wq = w + q * ldw;
+            for(size_t j = 0; j < nc; j++) wp[j] += tqp * wq[j];
+        }
+    }
+
+    // C -= V W, each row of C is streamed once more
+    for(size_t r = kb; r < a.rows; r++)
+    {
+        double* c = LA_UNPACK(a)[r] + ke;
+        size_t pe = r - kb + 1 < nb ? r - kb + 1 : nb;
+        for(size_t p = 0; p < pe; p++)
+        {
+            double v = r == kb + p ? 1.0 : LA_UNPACK(a)[r][kb + p];
+            const double* wp = w + p * ldw;
+            for(size_t j = 0; j < nc; j++) c[j] -= v * wp[j];
+        }
+    }
+}
+
+// QR factorize A(m x n, m >= n) in place with blocked householder reflections(compact WY)
+int mat2DQRFactor(Mat2d* A, Vec* tau, Mat2d* work)
+{
+    LINALG_TRACE_SCOPE(A ? A->rows : 0, A ? A->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!A || !A->mat || !tau || !tau->x || !work || !work->mat, LINALG_ERROR, "input/output/scratch is null!");
+    LINALG_ASSERT_ERROR(A->rows < A->cols, LINALG_ERROR, "invalid operation: QR factorization of underdetermined matrix mat(%zux%zu)", A->rows, A->cols);
+    LINALG_ASSERT_ERROR(tau->len != A->cols, LINALG_ERROR, "invalid vector: QR of mat(%zux%zu) with tau vec(%zu)", A->rows, A->cols, tau->len);
+    LINALG_ASSERT_ERROR(work->rows * work->cols < LINALG_QR_BLOCK * (A->cols + LINALG_QR_BLOCK), LINALG_ERROR,
+                        "invalid scratch: QR of mat(%zux%zu) needs %d x %zu scratch, got mat(%zux%zu)", A->rows, A->cols, LINALG_QR_BLOCK, A->cols + LINALG_QR_BLOCK, work->rows, work->cols);
+
+    Mat2d a = *A;
+    size_t n = a.cols;
+
+    // scratch: T(nb x nb) then W(nb x n)
+    double* t = work->mat;
+    double* w = work->mat + LINALG_QR_BLOCK * LINALG_QR_BLOCK;
+
+    for(size_t kb = 0; kb < n; kb += LINALG_QR_BLOCK)
+    {
+        size_t ke = kb + LINALG_QR_BLOCK < n ? kb + LINALG_QR_BLOCK : n;
+
+        qrPanel(a, kb, ke, tau, w);
+        if(ke == n) break;
+
+        // trailing update with one block reflector, a level 3 operation instead of nb rank 1 updates
+        qrPanelT(a, kb, ke, *tau, t, LINALG_QR_BLOCK, w);
+        qrApplyBlock(a, kb, ke, t, LINALG_QR_BLOCK, w, n - ke);
+    }
+
+    return LINALG_OK;
+}
+
+// B = Q^T B for the k columns of b(row stride ld), w needs k elements
+static void qrApplyQT(Mat2d qr, Vec tau, double* b, size_t ld, size_t k, double* w)
+{
+    for(size_t j = 0; j < qr.cols; j++)
+    {
+        double t = tau.x[j * tau.offset];
+        if(t == 0) continue;
+
+        memcpy(w, b + j * ld, k * sizeof(double));
+        for(size_t i = j + 1; i < qr.rows; i++)
+        {
+            double v = LA_UNPACK(qr)[i][j];
+            for(size_t c = 0; c < k; c++) w[c] += v * b[i * ld + c];
+        }
+
+        for(size_t c = 0; c < k; c++) b[j * ld + c] -= t * w[c];
+        for(size_t i = j + 1; i < qr.rows; i++)
+        {
+            double v = t * LA_UNPACK(qr)[i][j];
+            for(size_t c = 0; c < k; c++) b[i * ld + c] -= v * w[c];
+        }
+    }
+}
+
+// X = R^-1 B[0:n] for the k columns, b and x with row strides ldb and ldx
+static int qrBackSolve(Mat2d qr, const double* b, size_t ldb, double* x, size_t ldx, size_t k)
+{
+    size_t n = qr.cols;
+    for(size_t i = n; i-- > 0;)
+    {
+        const double* row = LA_UNPACK(qr)[i];
+        LINALG_ASSERT_ERROR(row[i] == 0, LINALG_ERROR, "matrix is rank deficient(R[%zu][%zu] is zero)!", i, i);
+
+        double* xi = x + i * ldx;
+        for(size_t c = 0; c < k; c++) xi[c] = b[i * ldb + c];
+        for(size_t j = i + 1; j < n; j++)
+        {
+            double r = row[j];
+            for(size_t c = 0; c < k; c++) xi[c] -= r * x[j * ldx + c];
+        }
+        for(size_t c = 0; c < k; c++) xi[c] /= row[i];
+    }
+    return LINALG_OK;
+}
+
+// least squares solve min ||Ax - b|| using a factorization from mat2DQRFactor
+int mat2DQRSolve(Mat2d QR, Vec tau, Vec* b, Vec* x)
+{
+    LINALG_TRACE_SCOPE(QR.rows, QR.cols, 0);
+    LINALG_ASSERT_ERROR(!QR.mat || !tau.x || !b || !b->x || !x || !x->x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(b->len != QR.rows || x->len != QR.cols || tau.len != QR.cols, LINALG_ERROR,
+                        "invalid vector: QR of mat(%zux%zu) with tau vec(%zu) applied over vec(%zu), result vec(%zu)", QR.rows, QR.cols, tau.len, b->len, x->len);
+
+    double w;
+    qrApplyQT(QR, tau, b->x, b->offset, 1, &w);
+    return qrBackSolve(QR, b->x, b->offset, x->x, x->offset, 1);
+}
+// least squares solve for every column of B using a factorization from mat2DQRFactor
+int mat2DQRSolveMulti(Mat2d QR, Vec tau, Mat2d* B, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(QR.rows, QR.cols, B ? B->cols : 0);
+    LINALG_ASSERT_ERROR(!QR.mat || !tau.x || !B || !B->mat || !X || !X->mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(B->rows != QR.rows || X->rows != QR.cols || B->cols != X->cols || tau.len != QR.cols, LINALG_ERROR,
+                        "invalid operation: QR of mat(%zux%zu) with tau vec(%zu) applied over mat(%zux%zu), result mat(%zux%zu)", QR.rows, QR.cols, tau.len, B->rows, B->cols, X->rows, X->cols);
+
+    // the first row of X is free until the back substitution reaches it
+    qrApplyQT(QR, tau, B->mat, B->cols, B->cols, X->mat);
+    return qrBackSolve(QR, B->mat, B->cols, X->mat, X->cols, X->cols);
+}
@@ -0,0 +1,345 @@
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+
+// LINALG_UNPACK_MAT(matrix, r, c)[x][y] = value at xth col and yth row
+#define LA_UNPACK(matrix) ((double (*)[matrix.cols]) matrix.mat)
+
+// columns factored together by mat2DCholeskyFactor
+#define LA_CHOL_BLOCK 64
+
+// Bunch-Kaufman pivot threshold, (1 + sqrt(17)) / 8
+#define LA_LDLT_ALPHA 0.6403882032022076
+
+// dot product of two contiguous arrays, 4 partial sums so the loop pipelines(and vectorizes)
+static double symDot(const double* a, const double* b, size_t n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for(; i < n; i++) s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// swap rows r1 and r2 of the k columns of a right hand side block(row stride ld)
+static void symSwapRows(double* b, size_t ld, size_t k, size_t r1, size_t r2)
+{
+    if(r1 == r2) return;
+    for(size_t c = 0; c < k; c++)
+    {
+        double tmp = b[r1 * ld + c];
+        b[r1 * ld + c] = b[r2 * ld + c];
+        b[r2 * ld + c] = tmp;
+    }
+}
+
+// factor A = L L^T in place, only the lower triangle of A is referenced and overwritten with L
+int mat2DCholeskyFactor(Mat2d* A)
+{
+    LINALG_TRACE_SCOPE(A ? A->rows : 0, 0, 0);
+    LINALG_ASSERT_ERROR(!A || !A->mat, LINALG_ERROR, "input matrix is null!");
+    LINALG_ASSERT_ERROR(A->rows != A->cols, LINALG_ERROR, "invalid operation: cholesky factorization of non square matrix mat(%zux%zu)", A->rows, A->cols);
+
+    size_t n = A->rows;
+    Mat2d a = *A;
+
+    for(size_t kb = 0; kb < n; kb += LA_CHOL_BLOCK)
+    {
+        size_t ke = kb + LA_CHOL_BLOCK < n ? kb + LA_CHOL_BLOCK : n;
+
+        // columns [kb, ke) of L, row by row(earlier blocks are already applied)
+        for(size_t i = kb; i < n; i++)
+        {
+            double* row_i = LA_UNPACK(a)[i];
+            size_t je = i + 1 < ke ? i + 1 : ke;
+            for(size_t j = kb; j < je; j++)
+            {
+                double s = row_i[j] - symDot(row_i + kb, LA_UNPACK(a)[j] + kb, j - kb);
+                if(i != j)
+                {
+                    row_i[j] = s / LA_UNPACK(a)[j][j];
+                    continue;
+                }
+
+                // cheap SPD check, a non positive pivot means A is not positive definite
+                LINALG_ASSERT_ERROR(!(s > 0), LINALG_ERROR, "matrix is not positive definite(pivot %zu is %le)!", j, s);
+                row_i[j] = sqrt(s);
+            }
+        }
+
+        // trailing update of the lower triangle, A22 -= L21 L21^T
+        for(size_t i = ke; i < n; i++)
+        {
+            double* row_i = LA_UNPACK(a)[i];
+            for(size_t j = ke; j <= i; j++) row_i[j] -= symDot(row_i + kb, LA_UNPACK(a)[j] + kb, ke - kb);
+        }
+    }
+
+    return LINALG_OK;
+}
+
+// solve L L^T X = B for the k columns of b(row stride ld), b holds B on entry
+static void cholSolveBlock(Mat2d L, double* b, size_t ld, size_t k)
+{
+    size_t n = L.rows;
+
+    // L Y = B
+    for(size_t i = 0; i < n; i++)
+    {
+        const double* row_i = LA_UNPACK(L)[i];
+        double* bi = b + i * ld;
+        for(size_t j = 0; j < i; j++)
+        {
+            double l = row_i[j];
+            const double* bj = b + j * ld;
+            for(size_t c = 0; c < k; c++) bi[c] -= l * bj[c];
+        }
+        for(size_t c = 0; c < k; c++) bi[c] /= row_i[i];
+    }
+
+    // L^T X = Y, walks rows of L so the access stays contiguous
+    for(size_t i = n; i-- > 0;)
+    {
+        const double* row_i = LA_UNPACK(L)[i];
+        double* bi = b + i * ld;
+        for(size_t c = 0; c < k; c++) bi[c] /= row_i[i];
+        for(size_t j = 0; j < i; j++)
+        {
+            double l = row_i[j];
+            double* bj = b + j * ld;
+            for(size_t c = 0; c < k; c++) bj[c] -= l * bi[c];
+        }
+    }
+}
+
+// solve A x = b using a factorization from mat2DCholeskyFactor, x holds b on entry
+int mat2DCholeskySolve(Mat2d L, Vec* x)
+{
+    LINALG_TRACE_SCOPE(L.rows, 0, 0);
+    LINALG_ASSERT_ERROR(!x || !x->x || !L.mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(L.rows != L.cols || L.rows != x->len, LINALG_ERROR, "invalid vector: cholesky factor mat(%zux%zu) applied over vec(%zu)", L.rows, L.cols, x->len);
+
+    cholSolveBlock(L, x->x, x->offset, 1);
+    return LINALG_OK;
+}
+// solve A X = B for every column of X using a factorization from mat2DCholeskyFactor, X holds B on entry
+int mat2DCholeskySolveMulti(Mat2d L, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(L.rows, X ? X->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!X || !X->mat || !L.mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(L.rows != L.cols || L.rows != X->rows, LINALG_ERROR, "invalid operation: cholesky factor mat(%zux%zu) applied over mat(%zux%zu)", L.rows, L.cols, X->rows, X->cols);
+
+    cholSolveBlock(L, X->mat, X->cols, X->cols);
+    return LINALG_OK;
+}
+
+// factor A = P L D L^T P^T in place(Bunch-Kaufman), only the lower triangle of A is referenced
+// follows LAPACK dsytf2(lower): D has 1x1 and 2x2 blocks, pivot[k] >= 0 is a 1x1 block with rows k and pivot[k] swapped,
+// pivot[k] = pivot[k + 1] = -(p + 1) is a 2x2 block with rows k + 1 and p swapped
+int mat2DLDLTFactor(Mat2d* A, long* pivot)
+{
+    LINALG_TRACE_SCOPE(A ? A->rows : 0, 0, 0);
+    LINALG_ASSERT_ERROR(!A || !A->mat || !pivot, LINALG_ERROR, "input matrix/pivot is null!");
+    LINALG_ASSERT_ERROR(A->rows != A->cols, LINALG_ERROR, "invalid operation: LDLT factorization of non square matrix mat(%zux%zu)", A->rows, A->cols);
+
+    size_t n = A->rows;
+    double (*a)[A->cols] = (double (*)[A->cols])A->mat;
+
+    size_t k = 0;
+    while(k < n)
+    {
+        size_t kstep = 1, kp = k;
+
+        double absakk = fabs(a[k][k]);
+        size_t imax = k;
+        double colmax = 0;
+        for(size_t i = k + 1; i < n; i++)
+        {
+            if(fabs(a[i][k]) > colmax)
+            {
+                colmax = fabs(a[i][k]);
+                imax = i;
+            }
+        }
+
+        LINALG_ASSERT_ERROR(absakk == 0 && colmax == 0, LINALG_ERROR, "matrix is singular at column %zu!", k);
+
+        if(absakk < LA_LDLT_ALPHA * colmax)
+        {
+            // largest off diagonal entry in row/column imax
+            double rowmax = 0;
+            for(size_t j = k; j < imax; j++) rowmax = fabs(a[imax][j]) > rowmax ? fabs(a[imax][j]) : rowmax;
+            for(size_t j = imax + 1; j < n; j++) rowmax = fabs(a[j][imax]) > rowmax ? fabs(a[j][imax]) : rowmax;
+
+            if(absakk >= LA_LDLT_ALPHA * colmax * (colmax / rowmax)) kp = k;
+            else if(fabs(a[imax][imax]) >= LA_LDLT_ALPHA * rowmax) kp = imax;
+            else
+            {
+                kp = imax;
+                kstep = 2;
+            }
+        }
+
+        // symmetric interchange of rows/columns kk and kp in the trailing matrix
+        size_t kk = k + kstep - 1;
+        if(kp != kk)
+        {
+            for(size_t i = kp + 1; i < n; i++)
+            {
+                double t = a[i][kk];
+                a[i][kk] = a[i][kp];
+                a[i][kp] = t;
+            }
+            for(size_t j = kk + 1; j < kp; j++)
+            {
+                double t = a[j][kk];
+                a[j][kk] = a[kp][j];
+                a[kp][j] = t;
+            }
+            double t = a[kk][kk];
+            a[kk][kk] = a[kp][kp];
+            a[kp][kp] = t;
+            if(kstep == 2)
+            {
+                t = a[k + 1][k];
+                a[k + 1][k] = a[kp][k];
+                a[kp][k] = t;
+            }
+        }
+
+        if(kstep == 1)
+        {
+            // rank 1 update, row by row: once row i is done a[i][k] holds l_i, which later rows use
+            double d11 = 1.0 / a[k][k];
+            for(size_t i = k + 1; i < n; i++)
+            {
+                double xi = a[i][k];
+                for(size_t j = k + 1; j < i; j++) a[i][j] -= xi * a[j][k];
+                a[i][i] -= xi * xi * d11;
+                a[i][k] = xi * d11;
+            }
+            pivot[k] = (long)kp;
+        }
+        else
+        {
+            // rank 2 update with the inverse of the 2x2 block, row by row as above
+            double d21 = a[k + 1][k];
+            double d11 = a[k + 1][k + 1] / d21;
+            double d22 = a[k][k] / d21;
+            double t = 1.0 / (d11 * d22 - 1.0);
+            d21 = t / d21;
+
+            for(size_t i = k + 2; i < n; i++)
+            {
+                double aik = a[i][k], aik1 = a[i][k + 1];
+                double wk = d21 * (d11 * aik - aik1);
+                double wkp1 = d21 * (d22 * aik1 - aik);
+
+                for(size_t j = k + 2; j < i; j++) a[i][j] -= aik * a[j][k] + aik1 * a[j][k + 1];
+                a[i][i] -= aik * wk + aik1 * wkp1;
+
+                a[i][k] = wk;
+                a[i][k + 1] = wkp1;
+            }
+            pivot[k] = pivot[k + 1] = -(long)kp - 1;
+        }
+
+        k += kstep;
+    }
+
+    return LINALG_OK;
+}
+
+// solve A X = B for the k columns of b(row stride ld) with a factorization from mat2DLDLTFactor(LAPACK dsytrs, lower)
+static void ldltSolveBlock(Mat2d LD, const long* pivot, double* b, size_t ld, size_t k)
+{
+    size_t n = LD.rows;
+    double (*a)[LD.cols] = LA_UNPACK(LD);
+
+    // L D Y = P B
+    for(size_t j = 0; j < n;)
+    {
+        if(pivot[j] >= 0)
+        {
+            symSwapRows(b, ld, k, j, (size_t)pivot[j]);
+            for(size_t i = j + 1; i < n; i++)
+            {
+                for(size_t c = 0; c < k; c++) b[i * ld + c] -= a[i][j] * b[j * ld + c];
+            }
+            for(size_t c = 0; c < k; c++) b[j * ld + c] /= a[j][j];
+            j++;
+            continue;
+        }
+
+        symSwapRows(b, ld, k, j + 1, (size_t)(-pivot[j] - 1));
+        for(size_t i = j + 2; i < n; i++)
+        {
+            for(size_t c = 0; c < k; c++) b[i * ld + c] -= a[i][j] * b[j * ld + c] + a[i][j + 1] * b[(j + 1) * ld + c];
+        }
+
+        double akm1k = a[j + 1][j];
+        double akm1 = a[j][j] / akm1k;
+        double ak = a[j + 1][j + 1] / akm1k;
+        double denom = akm1 * ak - 1.0;
+        for(size_t c = 0; c < k; c++)
+        {
+            double bkm1 = b[j * ld + c] / akm1k;
+            double bk = b[(j + 1) * ld + c] / akm1k;
+            b[j * ld + c] = (ak * bkm1 - bk) / denom;
+            b[(j + 1) * ld + c] = (akm1 * bk - bkm1) / denom;
+        }
+        j += 2;
+    }
+
+    // L^T P^T X = Y
+    for(size_t j = n; j-- > 0;)
+    {
+        for(size_t i = j + 1; i < n; i++)
+        {
+            for(size_t c = 0; c < k; c++) b[j * ld + c] -= a[i][j] * b[i * ld + c];
+        }
+
+        if(pivot[j] >= 0)
+        {
+            symSwapRows(b, ld, k, j, (size_t)pivot[j]);
+            continue;
+        }
+
+        // second column of a 2x2 block
+        for(size_t i = j + 1; i < n; i++)
+        {
+            for(size_t c = 0; c < k; c++) b[(j - 1) * ld + c] -= a[i][j - 1] * b[i * ld + c];
+        }
+        symSwapRows(b, ld, k, j, (size_t)(-pivot[j] - 1));
+        j--;
+    }
+}
+
+// solve A x = b using a factorization from mat2DLDLTFactor, x holds b on entry
+int mat2DLDLTSolve(Mat2d LD, const long* pivot, Vec* x)
+{
+    LINALG_TRACE_SCOPE(LD.rows, 0, 0);
+    LINALG_ASSERT_ERROR(!x || !x->x || !LD.mat || !pivot, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(LD.rows != LD.cols || LD.rows != x->len, LINALG_ERROR, "invalid vector: LDLT factor mat(%zux%zu) applied over vec(%zu)", LD.rows, LD.cols, x->len);
+
+    ldltSolveBlock(LD, pivot, x->x, x->offset, 1);
+    return LINALG_OK;
+}
+// solve A X = B for every column of X using a factorization from mat2DLDLTFactor, X holds B on entry
+int mat2DLDLTSolveMulti(Mat2d LD, const long* pivot, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(LD.rows, X ? X->cols : 0, 0);
+    LINALG_ASSERT_ERROR(!X || !X->mat || !LD.mat || !pivot, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(LD.rows != LD.cols || LD.rows != X->rows, LINALG_ERROR, "invalid operation: LDLT factor mat(%zux%zu) applied over mat(%zux%zu)", LD.rows, LD.cols, X->rows, X->cols);
+
+    ldltSolveBlock(LD, pivot, X->mat, X->cols, X->cols);
+    return LINALG_OK;
+}
@@ -0,0 +1,154 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+
+#ifdef LINALG_TRACE
+
+#include <stdatomic.h>
+#include <time.h>
+
+// events of one thread, only that thread writes to it
+typedef struct LinalgTraceRing
+{
+    struct LinalgTraceRing* next;
+    size_t tid;
+    // number of events begun, event i lives at i % LINALG_TRACE_RING
+    atomic_size_t head;
+    LinalgTraceEvent events[LINALG_TRACE_RING];
+} LinalgTraceRing;
+
+// every ring ever made, rings outlive their threads so the events of finished threads can still be written
+static _Atomic(LinalgTraceRing*) la_trace_rings = NULL;
+static atomic_size_t la_trace_threads = 0;
+static _Thread_local LinalgTraceRing* la_trace_ring = NULL;
+
+static uint64_t traceNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ring of the calling thread, made and linked in on first use
+static LinalgTraceRing* traceRing()
+{
+    if(la_trace_ring) return la_trace_ring;
+
+    LinalgTraceRing* ring = calloc(1, sizeof(LinalgTraceRing));
+    if(!ring) return NULL;
+    ring->tid = atomic_fetch_add(&la_trace_threads, 1);
+    atomic_init(&ring->head, 0);
+
+    LinalgTraceRing* head = atomic_load(&la_trace_rings);
+    do ring->next = head;
+    while(!atomic_compare_exchange_weak(&la_trace_rings, &head, ring));
+
+    la_trace_ring = ring;
+    return ring;
+}
+
+size_t linalgTraceBegin(const char* name, size_t d0, size_t d1, size_t d2)
+{
+    LinalgTraceRing* ring = traceRing();
+    if(!ring) return SIZE_MAX;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    LinalgTraceEvent* event = &ring->events[head % LINALG_TRACE_RING];
+    event->name = name;
+    event->dims[0] = d0;
+    event->dims[1] = d1;
+    event->dims[2] = d2;
+    event->end = 0;
+    event->begin = traceNow();
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return head;
+}
+
+void linalgTraceEnd(size_t* seq)
+{
+    // events begin and end on the same thread, so the ring is this thread's
+    LinalgTraceRing* ring = la_trace_ring;
+    if(!ring || *seq == SIZE_MAX) return;
+
+    // more than LINALG_TRACE_RING events nested inside this one reused its slot, the newer event keeps it
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if(head - *seq > LINALG_TRACE_RING) return;
+    ring->events[*seq % LINALG_TRACE_RING].end = traceNow();
+}
+
+int linalgTraceWrite(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    LINALG_ASSERT_ERROR(!file, LINALG_ERROR, "could not open %s for writing!", filename);
+
+    // timestamps relative to the first retained event
+    uint64_t origin = UINT64_MAX;
+    for(LinalgTraceRing* ring = atomic_load(&la_trace_rings); ring; ring = ring->next)
+    {
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t first = head > LINALG_TRACE_RING ? head - LINALG_TRACE_RING : 0;
+        for(size_t i = first; i < head; i++)
+        {
+            uint64_t begin = ring->events[i % LINALG_TRACE_RING].begin;
+            origin = begin < origin ? begin : origin;
+        }
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    int first_event = 1;
+    for(LinalgTraceRing* ring = atomic_load(&la_trace_rings); ring; ring = ring->next)
+    {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"linalg thread %zu\"}}",
+                first_event ? "" : ",\n", ring->tid, ring->tid);
+        first_event = 0;
+
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t first = head > LINALG_TRACE_RING ? head - LINALG_TRACE_RING : 0;
+        for(size_t i = first; i < head; i++)
+        {
+            LinalgTraceEvent event = ring->events[i % LINALG_TRACE_RING];
+            // still running(or overwritten while nested)
+            if(event.end < event.begin) continue;
+
+            // complete events, timestamps in microseconds
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"linalg\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%zu,"
+                          "\"args\":{\"d0\":%zu,\"d1\":%zu,\"d2\":%zu}}",
+                    event.name, (double)(event.begin - origin) * 1e-3, (double)(event.end - event.begin) * 1e-3, ring->tid,
+                    event.dims[0], event.dims[1], event.dims[2]);
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    int failed = ferror(file);
+    fclose(file);
+    LINALG_ASSERT_ERROR(failed, LINALG_ERROR, "could not write trace to %s!", filename);
+    return LINALG_OK;
+}
+
+void linalgTraceClear()
+{
+    for(LinalgTraceRing* ring = atomic_load(&la_trace_rings); ring; ring = ring->next)
+    {
+        atomic_store(&ring->head, 0);
+    }
+}
+
+#else
+
+int linalgTraceWrite(const char* filename)
+{
+    LINALG_REPORT_ERROR("tracing is not compiled in, build with -DLINALG_TRACE to write %s!", filename);
+    return LINALG_ERROR;
+}
+
+void linalgTraceClear()
+{
+}
+
+#endif
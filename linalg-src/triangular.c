@@ -0,0 +1,461 @@
+#include "../linalg.h"
+
+#include <stdlib.h>
+#include <memory.h>
+#include <math.h>
+
+// bytes of a column panel of the right hand sides swept at once by the multi right hand side kernels,
+// the panel stays in cache while the triangle streams over it once
+#define LA_TRI_PANEL_BYTES ((size_t)1 << 20)
+
+// one triangle of a full or packed matrix, row i is addressed with the column as index(see triRow)
+typedef struct TriView
+{
+    const double* x;
+    size_t n;
+    // row stride of full storage, 0 for packed
+    size_t ld;
+    int uplo;
+} TriView;
+
+static inline TriView triViewFull(Mat2d A, int uplo)
+{
+    TriView view = { A.mat, A.rows, A.cols, uplo };
+    return view;
+}
+static inline TriView triViewPacked(MatPacked A)
+{
+    TriView view = { A.x, A.n, 0, A.uplo };
+    return view;
+}
+
+// row i of the triangle, shifted so element j of the result is A[i][j](only the stored columns may be read)
+static inline const double* triRow(TriView a, size_t i)
+{
+    if(a.ld) return a.x + i * a.ld;
+    if(a.uplo == LINALG_LOWER) return a.x + i * (i + 1) / 2;
+    // rows before i hold n - r elements each, row i starts at column i
+    return a.x + i * a.n - i * (i + 1) / 2;
+}
+
+// dot product of a contiguous row with a strided vector, 4 partial sums so the loop pipelines
+static double triDot(const double* a, const double* x, size_t s, size_t n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        s0 += a[i] * x[i * s];
+        s1 += a[i + 1] * x[(i + 1) * s];
+        s2 += a[i + 2] * x[(i + 2) * s];
+        s3 += a[i + 3] * x[(i + 3) * s];
+    }
+    for(; i < n; i++) s0 += a[i] * x[i * s];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// b_i += scale * sum over j in [j0, j1) of row[j] b_j, for the k columns of b(row stride ld)
+// 4 rows of b are folded in per pass over b_i, so b_i is loaded and stored a quarter as often
+static inline void triRowGather(const double* row, double scale, double* b, size_t ld, size_t k, size_t i, size_t j0, size_t j1)
+{
+    double* restrict bi = b + i * ld;
+    if(k == 1)
+    {
+        bi[0] += scale * triDot(row + j0, b + j0 * ld, ld, j1 - j0);
+        return;
+    }
+    size_t j = j0;
+    for(; j + 4 <= j1; j += 4)
+    {
+        double a0 = scale * row[j], a1 = scale * row[j + 1], a2 = scale * row[j + 2], a3 = scale * row[j + 3];
+        const double* restrict b0 = b + j * ld;
+        const double* restrict b1 = b0 + ld;
+        const double* restrict b2 = b1 + ld;
+        const double* restrict b3 = b2 + ld;
+        for(size_t c = 0; c < k; c++) bi[c] += (a0 * b0[c] + a1 * b1[c]) + (a2 * b2[c] + a3 * b3[c]);
+    }
+    for(; j < j1; j++)
+    {
+        double a = scale * row[j];
+        const double* restrict bj = b + j * ld;
+        for(size_t c = 0; c < k; c++) bi[c] += a * bj[c];
+    }
+}
+
+// b_j += scale * row[j] b_i for j in [j0, j1), for the k columns of b(row stride ld)
+static inline void triRowScatter(const double* row, double scale, double* b, size_t ld, size_t k, size_t i, size_t j0, size_t j1)
+{
+    const double* restrict bi = b + i * ld;
+    size_t j = j0;
+    for(; j + 2 <= j1; j += 2)
+    {
+        double a0 = scale * row[j], a1 = scale * row[j + 1];
+        double* restrict b0 = b + j * ld;
+        double* restrict b1 = b0 + ld;
+        for(size_t c = 0; c < k; c++)
+        {
+            b0[c] += a0 * bi[c];
+            b1[c] += a1 * bi[c];
+        }
+    }
+    for(; j < j1; j++)
+    {
+        double a = scale * row[j];
+        double* restrict bj = b + j * ld;
+        for(size_t c = 0; c < k; c++) bj[c] += a * bi[c];
+    }
+}
+
+static inline void triRowScale(double* b, size_t ld, size_t k, size_t i, double scale)
+{
+    for(size_t c = 0; c < k; c++) b[i * ld + c] *= scale;
+}
+
+// solve op(A)X = B for the k columns of b(row stride ld), b holds B on entry
+// A is always read by rows, op(A) = A gathers the solved rows into row i, op(A) = A^T scatters row i into the unsolved ones
+static void triSolveBlock(TriView a, int trans, int diag, double* b, size_t ld, size_t k)
+{
+    size_t n = a.n;
+    if(a.uplo == LINALG_LOWER && !trans)
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            const double* row = triRow(a, i);
+            triRowGather(row, -1.0, b, ld, k, i, 0, i);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, 1.0 / row[i]);
+        }
+    }
+    else if(a.uplo == LINALG_UPPER && !trans)
+    {
+        for(size_t i = n; i-- > 0;)
+        {
+            const double* row = triRow(a, i);
+            triRowGather(row, -1.0, b, ld, k, i, i + 1, n);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, 1.0 / row[i]);
+        }
+    }
+    else if(a.uplo == LINALG_LOWER)
+    {
+        // L^T X = B, x_i is final once the rows below it are done, then it's removed from the rows above
+        for(size_t i = n; i-- > 0;)
+        {
+            const double* row = triRow(a, i);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, 1.0 / row[i]);
+            triRowScatter(row, -1.0, b, ld, k, i, 0, i);
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            const double* row = triRow(a, i);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, 1.0 / row[i]);
+            triRowScatter(row, -1.0, b, ld, k, i, i + 1, n);
+        }
+    }
+}
+
+// X = op(A)X in place for the k columns of b(row stride ld), each row is computed before the rows it reads are overwritten
+static void triMulBlock(TriView a, int trans, int diag, double* b, size_t ld, size_t k)
+{
+    size_t n = a.n;
+    if(a.uplo == LINALG_LOWER && !trans)
+    {
+        for(size_t i = n; i-- > 0;)
+        {
+            const double* row = triRow(a, i);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, row[i]);
+            triRowGather(row, 1.0, b, ld, k, i, 0, i);
+        }
+    }
+    else if(a.uplo == LINALG_UPPER && !trans)
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            const double* row = triRow(a, i);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, row[i]);
+            triRowGather(row, 1.0, b, ld, k, i, i + 1, n);
+        }
+    }
+    else if(a.uplo == LINALG_LOWER)
+    {
+        // L^T X: row i of L adds x_i to the rows above it, which are still to be finished
+        for(size_t i = 0; i < n; i++)
+        {
+            const double* row = triRow(a, i);
+            triRowScatter(row, 1.0, b, ld, k, i, 0, i);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, row[i]);
+        }
+    }
+    else
+    {
+        for(size_t i = n; i-- > 0;)
+        {
+            const double* row = triRow(a, i);
+            triRowScatter(row, 1.0, b, ld, k, i, i + 1, n);
+            if(diag == LINALG_NON_UNIT) triRowScale(b, ld, k, i, row[i]);
+        }
+    }
+}
+
+typedef void (*TriBlockFn)(TriView a, int trans, int diag, double* b, size_t ld, size_t k);
+
+// run a block kernel over column panels of X that fit in LA_TRI_PANEL_BYTES
+static void triPanels(TriBlockFn fn, TriView a, int trans, int diag, Mat2d* X)
+{
+    size_t k = X->cols;
+    size_t width = LA_TRI_PANEL_BYTES / (sizeof(double) * (a.n > 0 ? a.n : 1));
+    width = width < 8 ? 8 : width & ~(size_t)7;
+
+    for(size_t c0 = 0; c0 < k; c0 += width)
+    {
+        fn(a, trans, diag, X->mat + c0, k, k - c0 < width ? k - c0 : width);
+    }
+}
+
+// one row of a contiguous symv in a single pass: returns row . x and adds xi * row to y
+static double triSymvRow(const double* restrict row, const double* restrict x, double* restrict y, double xi, size_t n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t j = 0;
+    for(; j + 4 <= n; j += 4)
+    {
+        s0 += row[j] * x[j];
+        s1 += row[j + 1] * x[j + 1];
+        s2 += row[j + 2] * x[j + 2];
+        s3 += row[j + 3] * x[j + 3];
+        y[j] += xi * row[j];
+        y[j + 1] += xi * row[j + 1];
+        y[j + 2] += xi * row[j + 2];
+        y[j + 3] += xi * row[j + 3];
+    }
+    for(; j < n; j++)
+    {
+        s0 += row[j] * x[j];
+        y[j] += xi * row[j];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+// y = alpha * Ax + beta * y for symmetric A stored as one triangle, each stored element is read once for both of its uses
+static void triSymv(TriView a, double alpha, Vec x, double beta, Vec* y)
+{
+    size_t n = a.n, xs = x.offset, ys = y->offset;
+    double* yx = y->x;
+
+    if(beta == 0.0)
+        for(size_t i = 0; i < n; i++) yx[i * ys] = 0.0;
+    else if(beta != 1.0)
+        for(size_t i = 0; i < n; i++) yx[i * ys] *= beta;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const double* row = triRow(a, i);
+        double xi = alpha * x.x[i * xs];
+        size_t j0 = a.uplo == LINALG_LOWER ? 0 : i + 1, j1 = a.uplo == LINALG_LOWER ? i : n;
+
+        // row i of the triangle is row i of A(the dot) and, mirrored, part of column i of A(the update)
+        double sum;
+        if(xs == 1 && ys == 1)
+        {
+            sum = triSymvRow(row + j0, x.x + j0, yx + j0, xi, j1 - j0);
+        }
+        else
+        {
+            sum = triDot(row + j0, x.x + j0 * xs, xs, j1 - j0);
+            for(size_t j = j0; j < j1; j++) yx[j * ys] += xi * row[j];
+        }
+        yx[i * ys] += alpha * sum + xi * row[i];
+    }
+}
+
+#define LA_TRI_CHECK_FLAGS(uplo, trans, diag, ret)                                                                                            \
+    LINALG_ASSERT_ERROR((uplo != LINALG_LOWER && uplo != LINALG_UPPER) || (trans != LINALG_NO_TRANS && trans != LINALG_TRANS) ||               \
+                        (diag != LINALG_NON_UNIT && diag != LINALG_UNIT), ret, "invalid uplo(%d), trans(%d) or diag(%d)!", uplo, trans, diag)
+
+MatPacked packedInitZeroA(size_t n, int uplo)
+{
+    MatPacked mat = { NULL, 0, uplo };
+    LINALG_ASSERT_ERROR(uplo != LINALG_LOWER && uplo != LINALG_UPPER, mat, "invalid uplo(%d)!", uplo);
+
+    mat.x = (double*)calloc(n * (n + 1) / 2, sizeof(double));
+    mat.n = n;
+    LINALG_ASSERT_ERROR(!mat.x && n > 0, mat, "unkown error occured when allocation memory!");
+    return mat;
+}
+
+// pack the uplo triangle of A into result
+int mat2DPack(Mat2d A, MatPacked* result)
+{
+    LINALG_TRACE_SCOPE(A.rows, 0, 0);
+    LINALG_ASSERT_ERROR(!A.mat || !result || !result->x, LINALG_ERROR, "input/result matrix is null!");
+    LINALG_ASSERT_ERROR(A.rows != A.cols || A.rows != result->n, LINALG_ERROR, "invalid operation: mat(%zux%zu) packed into a packed matrix(%zu)", A.rows, A.cols, result->n);
+
+    TriView dst = triViewPacked(*result);
+    for(size_t i = 0; i < A.rows; i++)
+    {
+        size_t j0 = result->uplo == LINALG_LOWER ? 0 : i, j1 = result->uplo == LINALG_LOWER ? i + 1 : A.cols;
+        memcpy((double*)triRow(dst, i) + j0, A.mat + i * A.cols + j0, (j1 - j0) * sizeof(double));
+    }
+    return LINALG_OK;
+}
+// pack the uplo triangle of A(allocates memory)
+MatPacked mat2DPackA(Mat2d A, int uplo)
+{
+    MatPacked result = packedInitZeroA(A.rows, uplo);
+    mat2DPack(A, &result);
+    return result;
+}
+
+// unpack into a full matrix, the other triangle is mirrored if symmetric, else zeroed
+int packedUnpack(MatPacked A, int symmetric, Mat2d* result)
+{
+    LINALG_TRACE_SCOPE(A.n, 0, 0);
+    LINALG_ASSERT_ERROR(!A.x || !result || !result->mat, LINALG_ERROR, "input/result matrix is null!");
+    LINALG_ASSERT_ERROR(result->rows != A.n || result->cols != A.n, LINALG_ERROR, "invalid operation: packed matrix(%zu) unpacked into mat(%zux%zu)", A.n, result->rows, result->cols);
+
+    TriView src = triViewPacked(A);
+    size_t n = A.n;
+    for(size_t i = 0; i < n; i++)
+    {
+        const double* row = triRow(src, i);
+        double* out = result->mat + i * n;
+        for(size_t j = 0; j < n; j++)
+        {
+            int stored = A.uplo == LINALG_LOWER ? j <= i : j >= i;
+            out[j] = stored ? row[j] : symmetric ? triRow(src, j)[i] : 0.0;
+        }
+    }
+    return LINALG_OK;
+}
+
+// gets the element at row and col(by ref), NULL if it's out of bounds or in the triangle that isn't stored
+double* packedRef(MatPacked A, size_t row, size_t col)
+{
+    LINALG_ASSERT_ERROR(row >= A.n || col >= A.n, NULL, "index(%zu, %zu) out of bounds for packed matrix(%zu)", row, col, A.n);
+    if(A.uplo == LINALG_LOWER ? col > row : col < row) return NULL;
+    return (double*)triRow(triViewPacked(A), row) + col;
+}
+
+// compute y = alpha * Ax + beta * y for symmetric A, only the uplo triangle is read
+int mat2DSymv(double alpha, Mat2d A, int uplo, Vec x, double beta, Vec* y)
+{
+    LINALG_TRACE_SCOPE(A.rows, 0, 0);
+    LA_TRI_CHECK_FLAGS(uplo, LINALG_NO_TRANS, LINALG_NON_UNIT, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.mat || !x.x || !y || !y->x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(A.rows != A.cols || x.len != A.rows || y->len != A.rows, LINALG_ERROR,
+                        "invalid vector: symmetric mat(%zux%zu) applied over vec(%zu), result vec(%zu)", A.rows, A.cols, x.len, y->len);
+    LINALG_ASSERT_ERROR(x.x == y->x, LINALG_ERROR, "result vector can not alias the input!");
+
+    triSymv(triViewFull(A, uplo), alpha, x, beta, y);
+    return LINALG_OK;
+}
+// compute x = op(A)x for triangular A, only the uplo triangle is read
+int mat2DTrmv(Mat2d A, int uplo, int trans, int diag, Vec* x)
+{
+    LINALG_TRACE_SCOPE(A.rows, 0, 0);
+    LA_TRI_CHECK_FLAGS(uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.mat || !x || !x->x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(A.rows != A.cols || x->len != A.rows, LINALG_ERROR, "invalid vector: triangular mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x->len);
+
+    triMulBlock(triViewFull(A, uplo), trans, diag, x->x, x->offset, 1);
+    return LINALG_OK;
+}
+// solve op(A)x = b for triangular A, x holds b on entry. only the uplo triangle is read
+int mat2DTrsv(Mat2d A, int uplo, int trans, int diag, Vec* x)
+{
+    LINALG_TRACE_SCOPE(A.rows, 0, 0);
+    LA_TRI_CHECK_FLAGS(uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.mat || !x || !x->x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(A.rows != A.cols || x->len != A.rows, LINALG_ERROR, "invalid vector: triangular mat(%zux%zu) applied over vec(%zu)", A.rows, A.cols, x->len);
+
+    triSolveBlock(triViewFull(A, uplo), trans, diag, x->x, x->offset, 1);
+    return LINALG_OK;
+}
+// compute X = op(A)X for triangular A, only the uplo triangle is read
+int mat2DTrmm(Mat2d A, int uplo, int trans, int diag, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(A.rows, X ? X->cols : 0, 0);
+    LA_TRI_CHECK_FLAGS(uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.mat || !X || !X->mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(A.rows != A.cols || X->rows != A.rows, LINALG_ERROR, "invalid operation: triangular mat(%zux%zu) applied over mat(%zux%zu)", A.rows, A.cols, X->rows, X->cols);
+
+    triPanels(triMulBlock, triViewFull(A, uplo), trans, diag, X);
+    return LINALG_OK;
+}
+// solve op(A)X = B for triangular A, X holds B on entry. only the uplo triangle is read
+int mat2DTrsm(Mat2d A, int uplo, int trans, int diag, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(A.rows, X ? X->cols : 0, 0);
+    LA_TRI_CHECK_FLAGS(uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.mat || !X || !X->mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(A.rows != A.cols || X->rows != A.rows, LINALG_ERROR, "invalid operation: triangular mat(%zux%zu) applied over mat(%zux%zu)", A.rows, A.cols, X->rows, X->cols);
+
+    triPanels(triSolveBlock, triViewFull(A, uplo), trans, diag, X);
+    return LINALG_OK;
+}
+
+// compute y = alpha * Ax + beta * y for packed symmetric A
+int packedSymv(double alpha, MatPacked A, Vec x, double beta, Vec* y)
+{
+    LINALG_TRACE_SCOPE(A.n, 0, 0);
+    LA_TRI_CHECK_FLAGS(A.uplo, LINALG_NO_TRANS, LINALG_NON_UNIT, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.x || !x.x || !y || !y->x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(x.len != A.n || y->len != A.n, LINALG_ERROR, "invalid vector: packed symmetric matrix(%zu) applied over vec(%zu), result vec(%zu)", A.n, x.len, y->len);
+    LINALG_ASSERT_ERROR(x.x == y->x, LINALG_ERROR, "result vector can not alias the input!");
+
+    triSymv(triViewPacked(A), alpha, x, beta, y);
+    return LINALG_OK;
+}
+// compute x = op(A)x for packed triangular A
+int packedTrmv(MatPacked A, int trans, int diag, Vec* x)
+{
+    LINALG_TRACE_SCOPE(A.n, 0, 0);
+    LA_TRI_CHECK_FLAGS(A.uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.x || !x || !x->x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(x->len != A.n, LINALG_ERROR, "invalid vector: packed triangular matrix(%zu) applied over vec(%zu)", A.n, x->len);
+
+    triMulBlock(triViewPacked(A), trans, diag, x->x, x->offset, 1);
+    return LINALG_OK;
+}
+// solve op(A)x = b for packed triangular A, x holds b on entry
+int packedTrsv(MatPacked A, int trans, int diag, Vec* x)
+{
+    LINALG_TRACE_SCOPE(A.n, 0, 0);
+    LA_TRI_CHECK_FLAGS(A.uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.x || !x || !x->x, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(x->len != A.n, LINALG_ERROR, "invalid vector: packed triangular matrix(%zu) applied over vec(%zu)", A.n, x->len);
+
+    triSolveBlock(triViewPacked(A), trans, diag, x->x, x->offset, 1);
+    return LINALG_OK;
+}
+// compute X = op(A)X for packed triangular A
+int packedTrmm(MatPacked A, int trans, int diag, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(A.n, X ? X->cols : 0, 0);
+    LA_TRI_CHECK_FLAGS(A.uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.x || !X || !X->mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(X->rows != A.n, LINALG_ERROR, "invalid operation: packed triangular matrix(%zu) applied over mat(%zux%zu)", A.n, X->rows, X->cols);
+
+    triPanels(triMulBlock, triViewPacked(A), trans, diag, X);
+    return LINALG_OK;
+}
+// solve op(A)X = B for packed triangular A, X holds B on entry
+int packedTrsm(MatPacked A, int trans, int diag, Mat2d* X)
+{
+    LINALG_TRACE_SCOPE(A.n, X ? X->cols : 0, 0);
+    LA_TRI_CHECK_FLAGS(A.uplo, trans, diag, LINALG_ERROR);
+    LINALG_ASSERT_ERROR(!A.x || !X || !X->mat, LINALG_ERROR, "input/output is null!");
+    LINALG_ASSERT_ERROR(X->rows != A.n, LINALG_ERROR, "invalid operation: packed triangular matrix(%zu) applied over mat(%zux%zu)", A.n, X->rows, X->cols);
+
+    triPanels(triSolveBlock, triViewPacked(A), trans, diag, X);
+    return LINALG_OK;
+}
+
+void freeMatPacked(MatPacked* mat)
+{
+    if(!mat->x) return;
+
+    free(mat->x);
+    mat->n = 0;
+}
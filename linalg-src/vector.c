@@ -17,6 +17,7 @@
 // initialzie the vector on the heap with some initial value
 Vec vecInitA(double value, size_t len)
 {
+    LINALG_TRACE_SCOPE(len, 0, 0);
     if(len == 0)
     {
         LINALG_REPORT_ERROR("invalid zero length vector requested!");
@@ -24,7 +25,9 @@ Vec vecInitA(double value, size_t len)
     }
     Vec x = { (double*)calloc(len, sizeof(double)), len, 1 };
     LINALG_ASSERT_ERROR(!x.x, x, "unkown error occured when allocation memory!");
-    for(size_t i = 0; i < x.len; i++) x.x[i] = value;
+    // calloc memory is already zero, filling it again would touch every page for nothing
+    if(value != 0.0 || signbit(value))
+        for(size_t i = 0; i < x.len; i++) x.x[i] = value;
     return x;
 }
 // initialize the vector on the heap to zeros
@@ -41,6 +44,7 @@ Vec vecInitOnesA(size_t len)
 // make a copy of a vector on heap
 Vec vecCopyA(Vec vector)
 {
+    LINALG_TRACE_SCOPE(vector.len, 0, 0);
     if(vector.len == 0)
     {
         LINALG_REPORT_ERROR("invalid zero length vector requested!");
@@ -59,6 +63,7 @@ Vec vecCopyA(Vec vector)
 // make a copy of a vector on another vector
 int vecCopy(Vec src, Vec* dst)
 {
+    LINALG_TRACE_SCOPE(src.len, 0, 0);
     LINALG_ASSERT_ERROR(src.len == 0, LINALG_ERROR, "source length is zero!");
     LINALG_ASSERT_ERROR(src.len != dst->len, LINALG_ERROR, "attempt to copy vectors with unqeual dimensions %zu to %zu!", src.len, dst->len);
     for(size_t i = 0; i < src.len; i++) LA_VIDX_PTR(dst, i) = LA_VIDX(src, i);
@@ -75,6 +80,7 @@ Vec vecConstruct(double* ptr, size_t len)
 // pretty print a vector
 void vecPrint(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     printf("[");
     for(size_t i = 0; i < a.len - 1; i++)
     {
@@ -105,6 +111,7 @@ double* vecRef(Vec a, size_t n)
 // add 2 vectors and get result into another vector
 int vecAdd(Vec a, Vec b, Vec* result)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(a.len != b.len, LINALG_ERROR, "attempt to add vectors with dimension %zu and %zu!", a.len, b.len);
     LINALG_ASSERT_ERROR(!result || !result->x, LINALG_ERROR, "result vector is null!");
     LINALG_ASSERT_ERROR(!a.x || !b.x, LINALG_ERROR, "input vector/s is/are null!");
@@ -118,9 +125,43 @@ int vecAdd(Vec a, Vec b, Vec* result)
 
     return LINALG_OK;
 }
+
+typedef struct VecAddArgs
+{
+    Vec a;
+    Vec b;
+    Vec* result;
+} VecAddArgs;
+
+static void vecAddTask(void* data, size_t begin, size_t end, size_t thread)
+{
+    VecAddArgs* args = data;
+    (void)thread;
+    for(size_t i = begin; i < end; i++)
+    {
+        LA_VIDX_PTR(args->result, i) = LA_VIDX(args->a, i) + LA_VIDX(args->b, i);
+    }
+}
+// add 2 vectors on the threads of ctx and get result into another vector, prints error if input is invalid
+int vecAddCtx(LinalgCtx* ctx, Vec a, Vec b, Vec* result)
+{
+    LINALG_TRACE_SCOPE(a.len, linalgCtxThreads(ctx), 0);
+    if(LINALG_CTX_SERIAL(ctx, a.len)) return vecAdd(a, b, result);
+
+    LINALG_ASSERT_ERROR(a.len != b.len, LINALG_ERROR, "attempt to add vectors with dimension %zu and %zu!", a.len, b.len);
+    LINALG_ASSERT_ERROR(!result || !result->x, LINALG_ERROR, "result vector is null!");
+    LINALG_ASSERT_ERROR(!a.x || !b.x, LINALG_ERROR, "input vector/s is/are null!");
+    LINALG_ASSERT_ERROR(b.len != result->len, LINALG_ERROR, "output dimension %zu does not match input dimension %zu!", result->len, b.len);
+
+    VecAddArgs args = { a, b, result };
+    linalgParallelFor(ctx, 0, a.len, LINALG_CTX_GRAIN(1), vecAddTask, &args);
+
+    return LINALG_OK;
+}
 // subtract 2 vectors(a - b) and get result into another vector, prints error if input is invalid
 int vecSub(Vec a, Vec b, Vec* result)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(a.len != b.len, LINALG_ERROR, "attempt to add vectors with dimension %zu and %zu!", a.len, b.len);
     LINALG_ASSERT_ERROR(!result || !result->x, LINALG_ERROR, "result vector is null!");
     LINALG_ASSERT_ERROR(!a.x || !b.x, LINALG_ERROR, "input vector/s is/are null!");
@@ -137,6 +178,7 @@ int vecSub(Vec a, Vec b, Vec* result)
 // multiply scalar value to vectors and get result into another vector
 int vecScale(double a, Vec b, Vec* result)
 {
+    LINALG_TRACE_SCOPE(b.len, 0, 0);
     LINALG_ASSERT_ERROR(!result || !result->x, LINALG_ERROR, "resultant vector is null!");
     LINALG_ASSERT_ERROR(!b.x, LINALG_ERROR, "input vector/s is/are null!");
     LINALG_ASSERT_ERROR(b.len < result->len, LINALG_ERROR, "output vector not big enough to store result!");
@@ -152,6 +194,7 @@ int vecScale(double a, Vec b, Vec* result)
 // divide a scalar value to vector and get result into another vector, prints error if input is invalid
 int vecRScale(double a, Vec b, Vec* result)
 {
+    LINALG_TRACE_SCOPE(b.len, 0, 0);
     LINALG_ASSERT_ERROR(!result || !result->x, LINALG_ERROR, "resultant vector is null!");
     LINALG_ASSERT_ERROR(!b.x, LINALG_ERROR, "input vector/s is/are null!");
     LINALG_ASSERT_ERROR(b.len < result->len, LINALG_ERROR, "output vector not big enough to store result!");
@@ -167,6 +210,7 @@ int vecRScale(double a, Vec b, Vec* result)
 // calculate exp of every component in vector and get result into another vector, prints error if input is invalid
 int vecExp(Vec b, Vec* result)
 {
+    LINALG_TRACE_SCOPE(b.len, 0, 0);
     LINALG_ASSERT_ERROR(!result || !result->x, LINALG_ERROR, "resultant vector is null!");
     LINALG_ASSERT_ERROR(!b.x, LINALG_ERROR, "input vector/s is/are null!");
     LINALG_ASSERT_ERROR(b.len < result->len, LINALG_ERROR, "output vector not big enough to store result!");
@@ -182,11 +226,13 @@ int vecExp(Vec b, Vec* result)
 // unit vector of the norm
 int vecNormalize(Vec a, Vec* result)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     return vecScale(1 / vecMagnitude(a), a, result);
 }
 // get the dot product between 2 variables
 double vecDot(Vec a, Vec b)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(a.len != b.len, NAN, "attempt to take dot product of vectors with dimension %zu and %zu!", a.len, b.len);
     LINALG_ASSERT_ERROR(!a.x || !b.x, NAN, "input vector/s is/are null!");
 
@@ -202,12 +248,14 @@ double vecDot(Vec a, Vec b)
 // get the L2 norm of vector
 double vecMagnitude(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     return sqrt(vecDot(a, a));
 }
 // get the L_p norm of vector, prints warning if p < 1
 // for p = inf use vecMax 
 double vecNorm(Vec a, double p)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_ERROR(p < 1, NAN, "L_p is not a valid norm for p = %f", p);
 
@@ -223,6 +271,7 @@ double vecNorm(Vec a, double p)
 // maximum value in the vector
 double vecMax(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, INFINITY, "max of a zero dimension vector");
 
@@ -238,6 +287,7 @@ double vecMax(Vec a)
 // maximum value(abs) in the vector
 double vecMaxAbs(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, INFINITY, "max of a zero dimension vector");
 
@@ -253,6 +303,7 @@ double vecMaxAbs(Vec a)
 // minimum value in the vector
 double vecMin(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, -INFINITY, "min of a zero dimension vector");
 
@@ -268,6 +319,7 @@ double vecMin(Vec a)
 // minimum value(abs) in the vector
 double vecMinAbs(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, -INFINITY, "min of a zero dimension vector");
 
@@ -283,6 +335,7 @@ double vecMinAbs(Vec a)
 // sum all values in a vector
 double vecSum(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, 0, "sum of a zero dimension vector");
 
@@ -294,6 +347,7 @@ double vecSum(Vec a)
 // return the product of all values in a vector
 double vecProd(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, 1, "product of a zero dimension vector");
 
@@ -305,6 +359,7 @@ double vecProd(Vec a)
 // get the range of vector, i.e max - min
 double vecRange(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, 0, "input is a zero dimension vector");
 
@@ -322,6 +377,7 @@ double vecRange(Vec a)
 // get the (relative) range of vector, i.e (max - min) / min( |max|, |min| )
 double vecRangeRelative(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, 0, "input is a zero dimension vector");
 
@@ -341,6 +397,7 @@ double vecRangeRelative(Vec a)
 // get the standard deviation of the vector
 double vecStandardDeviation(Vec a)
 {
+    LINALG_TRACE_SCOPE(a.len, 0, 0);
     LINALG_ASSERT_ERROR(!a.x, NAN, "input vector is null!");
     LINALG_ASSERT_WARN(a.len == 0, 0, "checking a zero dimension vector");
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdio.h>
+#include <stdint.h>
 #include "stack.h"
 
 #define LINALG_OK 0
@@ -52,6 +53,45 @@
 // This function is called in the LINALG_ERROR_TRAP macro
 void error_handler(const char* file, const char* function, size_t line_no);
 
+// Tracing
+
+// build everything with -DLINALG_TRACE to record a timeline of kernel calls, without it the macros expand to nothing
+// every public kernel records its begin/end time and up to 3 problem dimensions into a ring buffer of the calling thread
+// (no locks, the oldest events are overwritten), linalgTraceWrite flushes them as chrome trace event json(perfetto, chrome://tracing)
+
+// events kept per thread
+#ifndef LINALG_TRACE_RING
+#define LINALG_TRACE_RING (1 << 16)
+#endif
+
+typedef struct LinalgTraceEvent
+{
+    const char* name;
+    // CLOCK_MONOTONIC nanoseconds, end is 0 while the call is running
+    uint64_t begin;
+    uint64_t end;
+    size_t dims[3];
+} LinalgTraceEvent;
+
+#ifdef LINALG_TRACE
+// returns the sequence number of the event in the ring of the calling thread(SIZE_MAX if it could not be recorded)
+size_t linalgTraceBegin(const char* name, size_t d0, size_t d1, size_t d2);
+// the end is dropped if the event was already overwritten by newer ones
+void linalgTraceEnd(size_t* seq);
+// records the enclosing function from this point until it returns(needs gcc/clang cleanup attribute)
+#define LINALG_TRACE_SCOPE(d0, d1, d2) \
+        size_t la_trace_event __attribute__((cleanup(linalgTraceEnd))) = \
+        linalgTraceBegin(__func__, (size_t)(d0), (size_t)(d1), (size_t)(d2))
+#else
+#define LINALG_TRACE_SCOPE(d0, d1, d2)
+#endif
+
+// write the recorded events of all threads to filename as chrome trace event json, call it while no kernel is running
+// returns LINALG_ERROR if the file can not be written or tracing was not compiled in
+int linalgTraceWrite(const char* filename);
+// drop all recorded events, call it while no kernel is running
+void linalgTraceClear();
+
 // Vector implementation
 
 // a column vector
@@ -202,18 +242,71 @@ int mat2DScale(double a, Mat2d b, Mat2d* result);
 int mat2DTransform(Mat2d A, Vec x, Vec* result);
 // compute result = Ax(allocates result Vec). prints error if the input is invalid
 Vec mat2DTransformA(Mat2d A, Vec x);
+// compute result = A^T x, without forming A^T. prints error if the input is invalid
+int mat2DTransformT(Mat2d A, Vec x, Vec* result);
+// compute result = A^T x(allocates result Vec), without forming A^T. prints error if the input is invalid
+Vec mat2DTransformTA(Mat2d A, Vec x);
+// compute y = alpha * Ax + beta * y(y is not read if beta is zero). prints error if the input is invalid
+int mat2DGemv(double alpha, Mat2d A, Vec x, double beta, Vec* y);
+// compute y = alpha * A^T x + beta * y(y is not read if beta is zero), without forming A^T. prints error if the input is invalid
+int mat2DGemvT(double alpha, Mat2d A, Vec x, double beta, Vec* y);
 
 // compute result = A*B. prints error if the input is invalid
 int mat2DMul(Mat2d A, Mat2d B, Mat2d* result);
 // compute result = A*B(allocates memory). prints error if the input is invalid
 Mat2d mat2DMulA(Mat2d A, Mat2d B);
 
+// blocks at or below this size(in any dimension) are multiplied classically by mat2DMulStrassen
+#define LINALG_STRASSEN_CUTOFF 512
+
+// elements of scratch space needed by mat2DMulStrassen for a (mxk)*(kxn) product(0 if no level recurses)
+size_t mat2DMulStrassenWorkSize(size_t m, size_t k, size_t n, size_t cutoff);
+// compute result = A*B with Strassen-Winograd recursion(odd sizes are peeled), cutoff 0 uses LINALG_STRASSEN_CUTOFF
+// scratch space should hold at least mat2DMulStrassenWorkSize elements, result can not alias A or B
+// accuracy: the error is only bounded normwise, ||C - AB|| <= c (n/cutoff)^log2(18) cutoff^2 u ||A|| ||B||(u = 2^-53)
+// instead of |C - AB| <= n u |A||B| elementwise for mat2DMul, so small entries of C next to large ones can lose
+// relative accuracy. each recursion level costs roughly a decimal digit less in the worst case, fine for well scaled A and B
+int mat2DMulStrassen(Mat2d A, Mat2d B, Mat2d* result, size_t cutoff, Mat2d* work);
+
 // solve Ax = b using gauss elmination
 // scratch space should be nx(n+1) big and order should be n elements big
 int mat2DSqSolve(Mat2d A, Vec x, Mat2d* scratch, size_t* order, Vec* y);
 
-// compute result = A^T. prints error if the input is invalid
+// factor symmetric positive definite A = LL^T in place(blocked), only the lower triangle is referenced and overwritten with L
+// returns LINALG_ERROR if A is not positive definite(a pivot is not positive), the factor is then incomplete
+int mat2DCholeskyFactor(Mat2d* A);
+// solve Ax = b using a factorization from mat2DCholeskyFactor, x holds b on entry
+int mat2DCholeskySolve(Mat2d L, Vec* x);
+// solve AX = B for every column of X using a factorization from mat2DCholeskyFactor, X(nxk) holds B on entry
+int mat2DCholeskySolveMulti(Mat2d L, Mat2d* X);
+
+// factor symmetric(possibly indefinite) A = PLDL^TP^T in place with Bunch-Kaufman pivoting, only the lower triangle is referenced
+// D has 1x1 and 2x2 blocks, pivot should be n elements big(LAPACK dsytf2 convention, 0 based)
+// returns LINALG_ERROR if A is singular
+int mat2DLDLTFactor(Mat2d* A, long* pivot);
+// solve Ax = b using a factorization from mat2DLDLTFactor, x holds b on entry
+int mat2DLDLTSolve(Mat2d LD, const long* pivot, Vec* x);
+// solve AX = B for every column of X using a factorization from mat2DLDLTFactor, X(nxk) holds B on entry
+int mat2DLDLTSolveMulti(Mat2d LD, const long* pivot, Mat2d* X);
+
+// columns factored together by mat2DQRFactor
+#define LINALG_QR_BLOCK 32
+
+// QR factorize A(mxn, m >= n) in place with blocked householder reflections(compact WY, LAPACK dgeqrf layout)
+// R is left in the upper triangle, the reflectors below the diagonal and their scales in tau(n elements)
+// scratch space should hold at least LINALG_QR_BLOCK x (n + LINALG_QR_BLOCK) elements
+int mat2DQRFactor(Mat2d* A, Vec* tau, Mat2d* work);
+// least squares solve min ||Ax - b|| using a factorization from mat2DQRFactor
+// b(m elements) is overwritten with Q^T b, so the norm of its last m - n elements is the residual norm
+// returns LINALG_ERROR if R is singular(A is rank deficient)
+int mat2DQRSolve(Mat2d QR, Vec tau, Vec* b, Vec* x);
+// least squares solve for every column of B(mxk) into X(nxk) using a factorization from mat2DQRFactor, B is overwritten with Q^T B
+int mat2DQRSolveMulti(Mat2d QR, Vec tau, Mat2d* B, Mat2d* X);
+
+// compute result = A^T(blocked, A and result may be the same square matrix). prints error if the input is invalid
 int mat2DTranspose(Mat2d A, Mat2d* result);
+// compute A = A^T in place, A must be square. prints error if the input is invalid
+int mat2DTransposeSelf(Mat2d* A);
 
 // maximum value in the matrix, prints error if input is invalid
 double mat2DMax(Mat2d a);
@@ -223,6 +316,218 @@ double mat2DMin(Mat2d a);
 // free the matrix on the heap
 void freeMat2D(Mat2d* mat);
 
+// Symmetric and triangular storage
+
+// the triangle of a symmetric or triangular matrix that is stored(or read, for a full Mat2d)
+#define LINALG_LOWER 0
+#define LINALG_UPPER 1
+// op(A) of a triangular kernel, A or A^T
+#define LINALG_NO_TRANS 0
+#define LINALG_TRANS 1
+// the diagonal of a triangular matrix is stored, or taken as ones(and never read)
+#define LINALG_NON_UNIT 0
+#define LINALG_UNIT 1
+
+// one triangle(with the diagonal) of an nxn symmetric or triangular matrix packed row by row, n(n + 1)/2 elements
+// lower: A[i][j](j <= i) is at i(i + 1)/2 + j, upper: A[i][j](j >= i) is at in - i(i + 1)/2 + j
+typedef struct MatPacked
+{
+    double* x;
+    size_t n;
+    int uplo;
+} MatPacked;
+
+// initialize a packed matrix on the heap to zeros
+MatPacked packedInitZeroA(size_t n, int uplo);
+// pack the result->uplo triangle of square A, prints error if the input is invalid
+int mat2DPack(Mat2d A, MatPacked* result);
+// pack the uplo triangle of square A(allocates memory)
+MatPacked mat2DPackA(Mat2d A, int uplo);
+// unpack into a full matrix, the other triangle is mirrored if symmetric is set, else zeroed. prints error if the input is invalid
+int packedUnpack(MatPacked A, int symmetric, Mat2d* result);
+// gets the value at row and col(by ref), NULL if it's out of bounds or in the triangle that isn't stored
+double* packedRef(MatPacked A, size_t row, size_t col);
+
+// kernels on full storage only read the uplo triangle of A, the other one can hold anything(e.g. a second factor)
+// compute y = alpha * Ax + beta * y for symmetric A(y is not read if beta is zero), every stored element is read once
+int mat2DSymv(double alpha, Mat2d A, int uplo, Vec x, double beta, Vec* y);
+// compute x = op(A)x for triangular A
+int mat2DTrmv(Mat2d A, int uplo, int trans, int diag, Vec* x);
+// solve op(A)x = b for triangular A, x holds b on entry
+int mat2DTrsv(Mat2d A, int uplo, int trans, int diag, Vec* x);
+// compute X = op(A)X for triangular A, X(nxk) is swept in column panels that stay in cache
+int mat2DTrmm(Mat2d A, int uplo, int trans, int diag, Mat2d* X);
+// solve op(A)X = B for triangular A, X(nxk) holds B on entry and is swept in column panels that stay in cache
+int mat2DTrsm(Mat2d A, int uplo, int trans, int diag, Mat2d* X);
+
+// same kernels on packed storage(half the memory and traffic of a full matrix), A.uplo is the stored triangle
+int packedSymv(double alpha, MatPacked A, Vec x, double beta, Vec* y);
+int packedTrmv(MatPacked A, int trans, int diag, Vec* x);
+int packedTrsv(MatPacked A, int trans, int diag, Vec* x);
+int packedTrmm(MatPacked A, int trans, int diag, Mat2d* X);
+int packedTrsm(MatPacked A, int trans, int diag, Mat2d* X);
+
+// free the packed matrix on the heap
+void freeMatPacked(MatPacked* mat);
+
+// NumPy(.npy) file I/O, files hold native endian doubles and open directly with numpy.load
+
+// a file mapped into memory, views into it are valid until it's freed
+typedef struct LinalgMap
+{
+    void* base;
+    size_t size;
+} LinalgMap;
+
+// changes to a mapped view stay in memory(copy on write)
+#define LINALG_MAP_PRIVATE 0
+// changes to a mapped view are written back to the file
+#define LINALG_MAP_SHARED 1
+
+// save a vector as a 1 dimensional .npy file, prints error if the file can't be written
+int vecSaveNpy(Vec a, const char* path);
+// save a matrix as a 2 dimensional .npy file, prints error if the file can't be written
+int mat2DSaveNpy(Mat2d a, const char* path);
+// create a .npy file of rowsxcols zeros without writing them(sparse file), prints error if the file can't be written
+int mat2DCreateNpy(const char* path, size_t rows, size_t cols);
+
+// load a .npy file into a vector on the heap(1 dimensional, or a single row/col)
+Vec vecLoadNpyA(const char* path);
+// load a .npy file into a matrix on the heap(fortran ordered files are transposed to row major, 1 dimensional files load as a single row)
+Mat2d mat2DLoadNpyA(const char* path);
+
+// mmap a .npy file and view its data as a vector(no copy, pages are read on first access)
+// mode is LINALG_MAP_PRIVATE or LINALG_MAP_SHARED, free the view with freeLinalgMap(not freeVec)
+Vec vecLoadNpyMap(const char* path, int mode, LinalgMap* map);
+// mmap a .npy file and view its data as a matrix(no copy, pages are read on first access)
+// mode is LINALG_MAP_PRIVATE or LINALG_MAP_SHARED, free the view with freeLinalgMap(not freeMat2D)
+Mat2d mat2DLoadNpyMap(const char* path, int mode, LinalgMap* map);
+
+// unmap a file, every view into it is invalid after this
+void freeLinalgMap(LinalgMap* map);
+
+// Threading(POSIX threads, link with -pthread)
+
+// a pool of persistent worker threads, shared by all *Ctx kernels
+// a NULL context is valid everywhere and runs the kernel serially
+typedef struct LinalgCtx LinalgCtx;
+
+// body of a parallel for, processes the indices [begin, end)
+// thread is the index of the running thread(0 is the caller), for linalgCtxScratch
+typedef void (*LinalgRangeFn)(void* args, size_t begin, size_t end, size_t thread);
+
+// kernels with less work than this(about one element or multiply-add per unit) run inline on the calling thread
+#define LINALG_CTX_MIN_WORK ((size_t)1 << 16)
+// work per chunk of a parallel for
+#define LINALG_CTX_GRAIN_WORK ((size_t)1 << 14)
+// grain size(indices per chunk) for indices that cost work units each
+#define LINALG_CTX_GRAIN(work) ((work) >= LINALG_CTX_GRAIN_WORK ? (size_t)1 : LINALG_CTX_GRAIN_WORK / ((work) > 0 ? (work) : 1))
+// true if a kernel with this much work should not be split over ctx
+// kernels called from inside a parallel for run serially too, the pool and the scratch of the other threads are in use
+#define LINALG_CTX_SERIAL(ctx, work) (!(ctx) || linalgCtxThreads(ctx) == 1 || (work) < LINALG_CTX_MIN_WORK || linalgCtxInPool())
+
+// make a context with a pool of threads(0 for one per online cpu), the calling thread counts as thread 0
+// cpus is optional(NULL to not pin), else thread i is pinned to cpus[i](threads elements)
+LinalgCtx* linalgCtxInitA(size_t threads, const int* cpus);
+// number of threads in the context(including the caller), 1 for a NULL context
+size_t linalgCtxThreads(LinalgCtx* ctx);
+// index of the calling thread in the pool running it(0 outside a parallel for)
+size_t linalgCtxThreadIndex();
+// nonzero if the calling thread is inside a parallel for(nested parallel fors run inline)
+int linalgCtxInPool();
+// scratch memory of thread(at least size bytes, cache line aligned), valid until it is requested bigger or the context is freed
+// only thread itself(or the caller outside a parallel for) may use it, the contents are lost when it grows
+void* linalgCtxScratch(LinalgCtx* ctx, size_t thread, size_t size);
+
+// call fn over [begin, end) in chunks of grain indices, on all threads of ctx, returns when every chunk is done
+// each thread starts on its own contiguous share and steals chunks from the others once it runs out
+// runs inline(as a single chunk) for a NULL context, a range of a single chunk, or when called from inside a parallel for
+void linalgParallelFor(LinalgCtx* ctx, size_t begin, size_t end, size_t grain, LinalgRangeFn fn, void* args);
+
+// stop the threads and free the context
+void freeLinalgCtx(LinalgCtx* ctx);
+
+// buffers of at least this many bytes made by the Ctx initializers are aligned to it and advised as transparent huge pages
+#define LINALG_HUGE_PAGE ((size_t)1 << 21)
+
+// initialize the vector on the heap for the threads of ctx(free with freeVec). each thread writes the elements a parallel
+// for over the vector gives it first, so on numa machines their pages are placed on its node(first touch)
+Vec vecInitCtxA(LinalgCtx* ctx, double value, size_t len);
+// initialize the matrix on the heap for the threads of ctx(free with freeMat2D), pages are first touched by rows
+// the same way the row parallel kernels(mat2DTransformCtx, mat2DMulCtx, ...) split them
+Mat2d mat2DInitCtxA(LinalgCtx* ctx, double value, size_t rows, size_t cols);
+
+// add 2 vectors on the threads of ctx and get result into another vector, prints error if input is invalid
+int vecAddCtx(LinalgCtx* ctx, Vec a, Vec b, Vec* result);
+// compute result = Ax on the threads of ctx. prints error if the input is invalid
+int mat2DTransformCtx(LinalgCtx* ctx, Mat2d A, Vec x, Vec* result);
+// compute result = A^T x on the threads of ctx, without forming A^T. prints error if the input is invalid
+int mat2DTransformTCtx(LinalgCtx* ctx, Mat2d A, Vec x, Vec* result);
+// compute y = alpha * Ax + beta * y on the threads of ctx(y is not read if beta is zero). prints error if the input is invalid
+int mat2DGemvCtx(LinalgCtx* ctx, double alpha, Mat2d A, Vec x, double beta, Vec* y);
+// compute y = alpha * A^T x + beta * y on the threads of ctx(y is not read if beta is zero). prints error if the input is invalid
+// uses n elements of scratch per thread
+int mat2DGemvTCtx(LinalgCtx* ctx, double alpha, Mat2d A, Vec x, double beta, Vec* y);
+// compute result = A*B on the threads of ctx. prints error if the input is invalid
+int mat2DMulCtx(LinalgCtx* ctx, Mat2d A, Mat2d B, Mat2d* result);
+// compute result = A*B with Strassen-Winograd recursion(see mat2DMulStrassen), the classical products run on the threads of ctx
+int mat2DMulStrassenCtx(LinalgCtx* ctx, Mat2d A, Mat2d B, Mat2d* result, size_t cutoff, Mat2d* work);
+// compute result = A*B for matrices that don't fit in memory, typically views from mat2DLoadNpyMap(result mapped LINALG_MAP_SHARED)
+// works on tiles that fit in budget bytes(allocates memory), a helper thread loads the next tiles and stores finished ones while
+// the current tiles are multiplied on the threads of ctx. mapped pages outside the tiles are page cache the os can reclaim
+// prints error if the input is invalid or budget is too small for a tile(32x32 tiles, 48KB, unless the matrices are smaller)
+int mat2DMulOutOfCore(LinalgCtx* ctx, Mat2d A, Mat2d B, Mat2d* result, size_t budget);
+// compute result = A^T on the threads of ctx(A and result may be the same square matrix). prints error if the input is invalid
+int mat2DTransposeCtx(LinalgCtx* ctx, Mat2d A, Mat2d* result);
+
+// Single precision storage
+
+// a column vector of floats, same layout as Vec
+typedef struct VecF {
+    float* x;
+    size_t len;
+    size_t offset;
+} VecF;
+
+// a matrix of floats, same layout as Mat2d
+typedef struct Mat2dF
+{
+    float* mat;
+    size_t rows;
+    size_t cols;
+} Mat2dF;
+
+// initialize the vector on the heap to zeros
+VecF vecFInitZerosA(size_t len);
+// initialize the matrix on the heap to zeros
+Mat2dF mat2DFInitZerosA(size_t rows, size_t cols);
+
+// round a double vector to floats, prints error if input is invalid
+int vecToF(Vec src, VecF* dst);
+// widen a float vector to doubles, prints error if input is invalid
+int vecFromF(VecF src, Vec* dst);
+// round a double matrix to floats, prints error if input is invalid
+int mat2DToF(Mat2d src, Mat2dF* dst);
+
+// LU factorize A in single precision(partial pivoting): lu = rounded A, factored in place
+// order receives the row permutation(n elements). returns LINALG_ERROR if a zero pivot is found
+int mat2DFLUFactor(Mat2d A, Mat2dF* lu, size_t* order);
+// solve LU x = b in single precision using a factorization from mat2DFLUFactor, x holds b on entry
+int mat2DFLUSolve(Mat2dF lu, const size_t* order, VecF* x);
+
+// solve Ax = b to double precision, with a single precision factorization and iterative refinement
+// the O(n^3) factorization runs in float, only the O(n^2) residuals are computed in double
+// lu must be nxn, order n elements, work and residual n elements big
+// returns LINALG_ERROR(with a warning) if refinement does not converge(e.g. A is too ill conditioned for float),
+// it stops as soon as the residual grows and y then holds the iterate with the smallest residual(up to the rounding of
+// taking the last correction back), mat2DSqSolve should be used instead
+int mat2DSqSolveMixed(Mat2d A, Vec b, Mat2dF* lu, size_t* order, VecF* work, Vec* residual, Vec* y);
+
+// free the vector on the heap
+void freeVecF(VecF* vec);
+// free the matrix on the heap
+void freeMat2DF(Mat2dF* mat);
+
 // a square matrix, with only 3 diagonals
 // as it's non zero elements
 typedef struct MatTriDiag
@@ -252,9 +557,85 @@ int triDiagSubDiagonalSelf(MatTriDiag* a, Vec diag);
 
 // solve Ax = b using tridiagonal matrix algorithm
 void triDiagSolveDestructive(MatTriDiag* A, Vec* x);
+// solve AX = B for every column of X(nxk, holds B on entry) using tridiagonal matrix algorithm
+// the elimination runs once for all k columns, row by row
+void triDiagSolveMultiDestructive(MatTriDiag* A, Mat2d* X);
+// solve (A + sigma I)x = b in one sweep, x holds b on entry. scratch should be n elements big
+// A is only read(the shift is folded into the pivots), so it stays bit for bit the same and
+// several shifts can be solved at once from different threads with their own scratch
+int triDiagSolveShifted(MatTriDiag A, double sigma, Vec* x, Vec* scratch);
+// solve (A + diag(d))x = b in one sweep, x holds b on entry. scratch should be n elements big, A is only read
+int triDiagSolveShiftedDiag(MatTriDiag A, Vec d, Vec* x, Vec* scratch);
+
+// Line sweeps over grids, the threads of ctx(which may be NULL) take whole lines
+
+// solve (A + sigma I)x = b along every row of X(A is colsxcols) on the threads of ctx, X holds b on entry. A is only read
+// rows are swept in groups, transposed tile by tile, so the solve runs across neighbouring rows. scratch should be 2 cols elements big
+int triDiagSolveRowsCtx(LinalgCtx* ctx, MatTriDiag A, double sigma, Mat2d* X, Vec* scratch);
+// solve (A + sigma I)x = b along every column of X(A is rowsxrows) on the threads of ctx, X holds b on entry. A is only read
+// each elimination step runs over a contiguous strip of a row. scratch should be 2 rows elements big
+int triDiagSolveColsCtx(LinalgCtx* ctx, MatTriDiag A, double sigma, Mat2d* X, Vec* scratch);
+// one alternating direction implicit(peaceman-rachford) step of U' = -(Ax + Ay)U on the grid U, sigma is 2 / dt
+// Ax acts along the rows(colsxcols), Ay along the columns(rowsxrows), both are only read
+// work should be the size of U, scratch should be 2(rows + cols) elements big. prints error if the input is invalid
+int triDiagAdiStepCtx(LinalgCtx* ctx, MatTriDiag Ax, MatTriDiag Ay, double sigma, Mat2d* U, Mat2d* work, Vec* scratch);
+
+// Symmetric eigensolvers, A[i][i] = diagonal[i] and A[i][i - 1] = A[i - 1][i] = subdiagonal[i](superdiagonal is not referenced)
+
+// all eigenvalues(ascending) of symmetric tridiagonal A with implicit QL, O(n^2)
+// vectors is optional(NULL to skip, O(n^3)), if given row i of the nxn matrix receives the eigenvector of eigenvalue i
+// A.scratch is overwritten
+int triDiagSymEigen(MatTriDiag A, Vec* values, Mat2d* vectors);
+// number of eigenvalues of symmetric tridiagonal A less than x(sturm count), O(n)
+// maps a value range [lo, hi) to the index range [count(lo), count(hi))
+size_t triDiagSymEigenCount(MatTriDiag A, double x);
+// eigenvalues il to iu - 1(ascending, 0 based) of symmetric tridiagonal A with bisection, O(n) per eigenvalue
+// values should be iu - il elements big
+int triDiagSymEigenRange(MatTriDiag A, size_t il, size_t iu, Vec* values);
+// eigenvectors of symmetric tridiagonal A for k ascending eigenvalues(e.g. from triDiagSymEigenRange) with inverse iteration
+// row j of vectors(kxn) receives the unit eigenvector of values[j], O(n) per eigenvector outside of clusters
+// scratch space should hold at least 5n elements
+int triDiagSymEigenvectors(MatTriDiag A, Vec values, Mat2d* vectors, Mat2d* work);
 
 void freeMatTriDiag(MatTriDiag* mat);
 
+// one row of a packed tridiagonal matrix, sub = A[i][i - 1], diag = A[i][i], super = A[i][i + 1]
+// and the elimination coefficient of the solver, 32 bytes(two rows per cache line)
+typedef struct TriDiagRow
+{
+    double sub;
+    double diag;
+    double super;
+    double scratch;
+} TriDiagRow;
+
+// tridiagonal matrix with the entries of each row stored together in one aligned array(see TriDiagRow)
+// streams a single array(plus the vector) through the solver and matvec, instead of one per diagonal
+typedef struct MatTriDiagPacked
+{
+    TriDiagRow* rows;
+    size_t len;
+} MatTriDiagPacked;
+
+MatTriDiagPacked triDiagPackedInitA(double value, size_t n);
+MatTriDiagPacked triDiagPackedInitZeroA(size_t n);
+
+// copy A into the packed layout of result(same size). prints error if the input is invalid
+int triDiagPack(MatTriDiag A, MatTriDiagPacked* result);
+// copy A into a new packed matrix(allocates memory)
+MatTriDiagPacked triDiagPackA(MatTriDiag A);
+// copy packed A back into the separate diagonals of result(same size). prints error if the input is invalid
+int triDiagUnpack(MatTriDiagPacked A, MatTriDiag* result);
+
+// solve Ax = b using tridiagonal matrix algorithm, x holds b on entry. the scratch entries of A are overwritten
+void triDiagPackedSolveDestructive(MatTriDiagPacked* A, Vec* x);
+// compute result = Ax(result can not alias x). prints error if the input is invalid
+int triDiagPackedTransform(MatTriDiagPacked A, Vec x, Vec* result);
+// compute result = Ax(allocates result Vec). prints error if the input is invalid
+Vec triDiagPackedTransformA(MatTriDiagPacked A, Vec x);
+
+void freeMatTriDiagPacked(MatTriDiagPacked* mat);
+
 typedef struct Vec2
 {
     double x[2];
@@ -279,6 +660,45 @@ Vec2 blkTransform(Block2 A, Vec2 x);
 
 double blkDeterminant(Block2 A);
 
+// Batched small matrices
+
+// a batch of count KxK matrices(or K vectors) stored as structure of arrays:
+// component c of item b is at [c * stride + b], c = i * K + j for matrices and c = i for vectors
+// so every component is contiguous across the batch, and kernels vectorize over the batch
+// the kernels work chunk by chunk, so results may alias the inputs
+#define LINALG_BLK_BATCH_DECLARE(K) \
+    typedef struct Block##K##Batch \
+    { \
+        double* mat; \
+        size_t count; \
+        size_t stride; \
+    } Block##K##Batch; \
+    typedef struct Vec##K##Batch \
+    { \
+        double* x; \
+        size_t count; \
+        size_t stride; \
+    } Vec##K##Batch; \
+    /* allocate a zeroed batch on the heap */ \
+    Block##K##Batch blk##K##BatchInitA(size_t count); \
+    Vec##K##Batch vec##K##BatchInitA(size_t count); \
+    /* result = A * B for every item */ \
+    int blk##K##BatchMul(Block##K##Batch A, Block##K##Batch B, Block##K##Batch* result); \
+    /* y = A x for every item */ \
+    int blk##K##BatchTransform(Block##K##Batch A, Vec##K##Batch x, Vec##K##Batch* y); \
+    /* result = A^-1 for every item(partial pivoting, singular items give inf/nan) */ \
+    int blk##K##BatchInverse(Block##K##Batch A, Block##K##Batch* result); \
+    /* det[b] = determinant of item b, det must be count long */ \
+    int blk##K##BatchDeterminant(Block##K##Batch A, Vec* det); \
+    /* solve A x = y for every item(partial pivoting, singular items give inf/nan) */ \
+    int blk##K##BatchSolve(Block##K##Batch A, Vec##K##Batch y, Vec##K##Batch* x); \
+    void freeBlock##K##Batch(Block##K##Batch* batch); \
+    void freeVec##K##Batch(Vec##K##Batch* batch);
+
+LINALG_BLK_BATCH_DECLARE(2)
+LINALG_BLK_BATCH_DECLARE(3)
+LINALG_BLK_BATCH_DECLARE(4)
+
 // a square matrix, with only 3 diagonals
 // as it's non zero elements
 typedef struct MatBlock2TD
@@ -297,4 +717,72 @@ MatBlock2TD blkTriDiagInitZeroA(size_t n);
 // solve Ax = b using block tridiagonal matrix algorithm
 void blkTriDiagSolveSelf(MatBlock2TD* A, Vec2* x);
 
+// factorize A in place for blkTriDiagFactorSolve(the diagonal and scratch are overwritten, the subdiagonal is kept)
+void blkTriDiagFactorSelf(MatBlock2TD* A);
+// solve Ax = b using a factorization from blkTriDiagFactorSelf, x holds b on entry. the factorization can be reused
+void blkTriDiagFactorSolve(MatBlock2TD F, Vec2* x);
+
 void freeMatBlock2TD(MatBlock2TD* mat);
+
+// Newton iteration on block tridiagonal systems
+
+// one accepted newton iteration, x and residual are only valid during the monitor call
+typedef struct BlkNewtonIter
+{
+    size_t iteration;
+    double residual_norm;
+    double step_norm;
+    // fraction of the newton step taken by the line search
+    double damping;
+    // non zero if the jacobian was refactored for this iteration
+    int refactored;
+
+    const Vec2* x;
+    const Vec2* residual;
+    size_t len;
+} BlkNewtonIter;
+
+// residual F(x) of n blocks, returns LINALG_OK or LINALG_ERROR if F can not be evaluated at x(the line search backtracks)
+typedef int (*BlkNewtonResidualFn)(void* user, const Vec2* x, Vec2* residual);
+// fill the diagonal, sub and superdiagonal blocks of J = dF/dx at x, returns LINALG_OK or LINALG_ERROR
+typedef int (*BlkNewtonJacobianFn)(void* user, const Vec2* x, MatBlock2TD* J);
+// called after every accepted iteration
+typedef void (*BlkNewtonMonitorFn)(void* user, const BlkNewtonIter* iter);
+
+typedef struct BlkNewtonOptions
+{
+    size_t max_iter;
+    // converged once ||F|| <= atol + rtol ||F(x0)||
+    double atol;
+    double rtol;
+    // or once the step is below step_tol relative to ||x||
+    double step_tol;
+    // iterations a factorization is used for before refactoring, 1 is plain newton, k > 1 Shamanskii and 0 the chord method
+    size_t reuse;
+    // refactor early if the residual norm shrinks by less than this factor per iteration
+    double contraction;
+    // smallest damping tried by the backtracking line search(1 disables it)
+    double min_damping;
+
+    BlkNewtonMonitorFn monitor;
+    void* monitor_user;
+} BlkNewtonOptions;
+
+typedef struct BlkNewtonResult
+{
+    size_t iterations;
+    size_t factorizations;
+    double residual_norm;
+    int converged;
+} BlkNewtonResult;
+
+// default options: a factorization is reused for 3 iterations, damping down to 1/1024, tolerances of 1e-10
+BlkNewtonOptions blkNewtonDefaultOptions();
+
+// solve F(x) = 0 with damped newton iterations, J(n = J.len blocks) is filled by jacobian and factored in place
+// the factorization is reused for opts.reuse iterations and refactored early when convergence slows down
+// or the line search fails with a reused factorization
+// x holds the initial guess on entry and the last iterate on exit, work should be 4n elements big
+// returns LINALG_ERROR if a callback fails, the line search fails on a fresh factorization or max_iter is reached
+int blkTriDiagNewton(BlkNewtonResidualFn residual, BlkNewtonJacobianFn jacobian, void* user,
+                     Vec2* x, MatBlock2TD* J, Vec2* work, BlkNewtonOptions opts, BlkNewtonResult* result);
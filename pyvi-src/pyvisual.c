@@ -1,5 +1,21 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "../pyvisual.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define PYVI_LIVE_SHM 1
+#endif
+
 typedef struct PyViSectionData
 {
     // section name
@@ -7,30 +23,288 @@ typedef struct PyViSectionData
     // all the Vec data, in this section
     DynStack/*Vec*/ data;
     PyViBase parameter;
+
+    // ring sections(see pyviCreateSectionRing), ring is NULL otherwise
+    // iteration i lives in row i % ring_capacity of the slab
+    double* ring;
+    size_t ring_capacity;
+    // total number of iterations pushed
+    size_t pushed;
 } PyViSectionData;
 
+// number of the first iteration still retained by the section
+static size_t pyviSectionFirst(PyViSectionData section)
+{
+    if(!section.ring) return 0;
+    return section.pushed > section.ring_capacity ? section.pushed - section.ring_capacity : 0;
+}
+
+// number of iterations retained by the section
+static size_t pyviSectionCount(PyViSectionData section)
+{
+    return section.ring ? section.pushed - pyviSectionFirst(section) : section.data.len;
+}
+
+// iteration(by its number) of the section, must be retained
+static Vec pyviSectionIteration(PyViSectionData section, size_t iteration)
+{
+    if(!section.ring) return *(Vec*)dynStackGet(section.data, iteration);
+
+    size_t len = section.parameter.axis.len;
+    return vecConstruct(section.ring + (iteration % section.ring_capacity) * len, len);
+}
+
+// live segment, see pyviLiveStart in pyvisual.h for the layout
+#define PYVI_LIVE_MAGIC "PYVILIV1"
+#define PYVI_LIVE_ALIGN 64
+
+typedef struct PyViLiveHeader
+{
+    char magic[8];
+    uint64_t size;
+    uint64_t parameters;
+    uint64_t sections;
+    uint8_t reserved[32];
+} PyViLiveHeader;
+
+typedef struct PyViLiveEntry
+{
+    char name[PYVI_LIVE_NAME_LEN];
+    uint64_t param;
+    uint64_t len;
+    uint64_t offset;
+} PyViLiveEntry;
+
+// published snapshot of a section, followed by its len doubles
+typedef struct PyViLiveSlot
+{
+    _Atomic uint64_t seq;
+    uint64_t iteration;
+    uint64_t count;
+    uint8_t pad[40];
+    double data[];
+} PyViLiveSlot;
+
+struct PyViLive
+{
+    char* name;
+    uint8_t* base;
+    size_t size;
+
+    // slot and capacity of every section, by section id
+    PyViLiveSlot** slots;
+    size_t* lens;
+    size_t sections;
+};
+
 PyVi pyviInitA(const char* filename)
 {
     PyVi pyvi;
-    pyvi.file = fopen(filename, "w");
+    // binary mode, as XOR encoded iterations are written as raw bytes
+    pyvi.file = filename ? fopen(filename, "wb") : NULL;
     pyvi.sections = dynStackInit(sizeof(PyViSectionData));
     pyvi.parameters = dynStackInit(sizeof(PyViBase));
+    pyvi.encoding = PYVI_ENCODING_TEXT;
+    pyvi.live = NULL;
 
     return pyvi;
 }
 
+static size_t pyviLiveAlign(size_t size)
+{
+    return (size + PYVI_LIVE_ALIGN - 1) / PYVI_LIVE_ALIGN * PYVI_LIVE_ALIGN;
+}
+
+static void pyviLiveName(char* dst, const char* name)
+{
+    memset(dst, 0, PYVI_LIVE_NAME_LEN);
+    if(name) strncpy(dst, name, PYVI_LIVE_NAME_LEN - 1);
+}
+
+static void freePyViLive(PyViLive* live)
+{
+    if(!live) return;
+
+#ifdef PYVI_LIVE_SHM
+    if(live->base) munmap(live->base, live->size);
+    if(live->name) shm_unlink(live->name);
+#endif
+
+    free(live->name);
+    free(live->slots);
+    free(live->lens);
+    free(live);
+}
+
+int pyviLiveStart(PyVi* pyvi, const char* shm_name)
+{
+#ifdef PYVI_LIVE_SHM
+    LINALG_ASSERT_ERROR(!shm_name, LINALG_ERROR, "live segment needs a name!");
+    LINALG_ASSERT_ERROR(pyvi->live, LINALG_ERROR, "live view is already started!");
+
+    size_t params = pyvi->parameters.len, sections = pyvi->sections.len;
+
+    // header, entries, parameter data and then one slot per section, every block cache line aligned
+    size_t size = sizeof(PyViLiveHeader) + (params + sections) * sizeof(PyViLiveEntry);
+    for(size_t i = 0; i < params; i++) size += pyviLiveAlign(((PyViBase*)dynStackGet(pyvi->parameters, i))->axis.len * sizeof(double));
+    for(size_t i = 0; i < sections; i++) size += sizeof(PyViLiveSlot) + pyviLiveAlign(((PyViSectionData*)dynStackGet(pyvi->sections, i))->parameter.axis.len * sizeof(double));
+
+    PyViLive* live = calloc(1, sizeof(PyViLive));
+    LINALG_ASSERT_ERROR(!live, LINALG_ERROR, "unable to allocate live view!");
+    live->slots = calloc(sections ? sections : 1, sizeof(PyViLiveSlot*));
+    live->lens = calloc(sections ? sections : 1, sizeof(size_t));
+    // shm names start with a single slash
+    live->name = malloc(strlen(shm_name) + 2);
+    if(!live->slots || !live->lens || !live->name)
+    {
+        freePyViLive(live);
+        LINALG_REPORT_ERROR("unable to allocate live view!");
+        return LINALG_ERROR;
+    }
+    live->name[0] = '/';
+    strcpy(live->name + 1, shm_name[0] == '/' ? shm_name + 1 : shm_name);
+    live->sections = sections;
+
+    int fd = shm_open(live->name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        free(live->name);
+        live->name = NULL;
+        freePyViLive(live);
+        LINALG_REPORT_ERROR("could not create shared memory segment %s!", shm_name);
+        return LINALG_ERROR;
+    }
+    if(ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        freePyViLive(live);
+        LINALG_REPORT_ERROR("could not resize shared memory segment %s to %zu bytes!", shm_name, size);
+        return LINALG_ERROR;
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED)
+    {
+        freePyViLive(live);
+        LINALG_REPORT_ERROR("could not map shared memory segment %s!", shm_name);
+        return LINALG_ERROR;
+    }
+    live->base = base;
+    live->size = size;
+
+    // ftruncate zero fills, so every seq starts at 0(nothing published yet)
+    PyViLiveEntry* entries = (PyViLiveEntry*)(live->base + sizeof(PyViLiveHeader));
+    size_t offset = sizeof(PyViLiveHeader) + (params + sections) * sizeof(PyViLiveEntry);
+
+    for(size_t i = 0; i < params; i++)
+    {
+        PyViBase param = *(PyViBase*)dynStackGet(pyvi->parameters, i);
+        PyViLiveEntry* entry = &entries[i];
+        pyviLiveName(entry->name, param.name);
+        entry->param = UINT64_MAX;
+        entry->len = param.axis.len;
+        entry->offset = offset;
+
+        Vec dst = vecConstruct((double*)(live->base + offset), param.axis.len);
+        vecCopy(param.axis, &dst);
+        offset += pyviLiveAlign(param.axis.len * sizeof(double));
+    }
+
+    for(size_t i = 0; i < sections; i++)
+    {
+        PyViSectionData section = *(PyViSectionData*)dynStackGet(pyvi->sections, i);
+        PyViLiveEntry* entry = &entries[params + i];
+        pyviLiveName(entry->name, section.name);
+
+        // parameters are copied by value into sections, match them by their axis
+        entry->param = UINT64_MAX;
+        for(size_t j = 0; j < params; j++)
+        {
+            PyViBase param = *(PyViBase*)dynStackGet(pyvi->parameters, j);
+            if(param.axis.x == section.parameter.axis.x && param.name == section.parameter.name) entry->param = j;
+        }
+        entry->len = section.parameter.axis.len;
+        entry->offset = offset;
+
+        live->slots[i] = (PyViLiveSlot*)(live->base + offset);
+        live->lens[i] = section.parameter.axis.len;
+        offset += sizeof(PyViLiveSlot) + pyviLiveAlign(section.parameter.axis.len * sizeof(double));
+    }
+
+    PyViLiveHeader* header = (PyViLiveHeader*)live->base;
+    header->size = size;
+    header->parameters = params;
+    header->sections = sections;
+    // the magic goes last, a reader that sees it sees a complete table
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, PYVI_LIVE_MAGIC, sizeof(header->magic));
+
+    pyvi->live = live;
+    return LINALG_OK;
+#else
+    (void)pyvi;
+    LINALG_REPORT_ERROR("live view of %s needs POSIX shared memory!", shm_name);
+    return LINALG_ERROR;
+#endif
+}
+
+// copy an iteration into the slot of its section under the seqlock
+static void pyviLivePublish(PyViLive* live, size_t id, size_t iteration, Vec fx)
+{
+    if(id >= live->sections) return;
+
+    PyViLiveSlot* slot = live->slots[id];
+    size_t count = fx.len < live->lens[id] ? fx.len : live->lens[id];
+
+    uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->iteration = iteration;
+    slot->count = count;
+    if(fx.offset == 1) memcpy(slot->data, fx.x, count * sizeof(double));
+    else for(size_t i = 0; i < count; i++) slot->data[i] = *vecRef(fx, i);
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+void pyviSetEncoding(PyVi* pyvi, PyViEncoding encoding)
+{
+    pyvi->encoding = encoding;
+}
+
 PyViSec pyviCreateSection(PyVi* pyvi, const char* section_name, PyViBase p)
 {
     PyViSectionData section;
     section.name = section_name;
-    section.data = dynStackInit(sizeof(Vec));
+    // segmented, so pushing many iterations never copies the ones already stored
+    section.data = dynStackInitSegmented(sizeof(Vec), NULL);
     section.parameter = p;
+    section.ring = NULL;
+    section.ring_capacity = 0;
+    section.pushed = 0;
 
     dynStackPush(&pyvi->sections, &section);
 
     return (PyViSec){pyvi->sections.len - 1, pyvi};
 }
 
+PyViSec pyviCreateSectionRing(PyVi* pyvi, const char* section_name, PyViBase p, size_t capacity)
+{
+    LINALG_ASSERT_ERROR(capacity == 0 || p.axis.len == 0, ((PyViSec){(size_t)-1, NULL}), "ring section %s needs a non zero capacity and parameter length!", section_name);
+
+    double* ring = malloc(capacity * p.axis.len * sizeof(double));
+    LINALG_ASSERT_ERROR(!ring, ((PyViSec){(size_t)-1, NULL}), "unable to allocate ring of %zu iterations for section %s!", capacity, section_name);
+
+    PyViSec sec = pyviCreateSection(pyvi, section_name, p);
+
+    PyViSectionData* section = dynStackGet(pyvi->sections, sec.id);
+    section->ring = ring;
+    section->ring_capacity = capacity;
+
+    return sec;
+}
+
 PyViBase pyviCreateParameter(PyVi* pyvi, const char* param_name, Vec p)
 {
     PyViBase param;
@@ -45,20 +319,60 @@ PyViBase pyviCreateParameter(PyVi* pyvi, const char* param_name, Vec p)
 // push a vector fx varying with parameter x
 void pyviSectionPush(PyViSec section, Vec fx)
 {
-    Vec tmp = vecCopyA(fx);
-
+    LINALG_TRACE_SCOPE(fx.len, section.id, 0);
     PyViSectionData* sec = dynStackGet(section.pyvi->sections, section.id);
 
+    if(section.pyvi->live) pyviLivePublish(section.pyvi->live, section.id, sec->pushed, fx);
+
+    // live only, nothing is kept for pyviWrite
+    if(!section.pyvi->file)
+    {
+        sec->pushed++;
+        return;
+    }
+
+    // ring sections overwrite the oldest iteration in place, no allocation
+    if(sec->ring)
+    {
+        Vec slot = pyviSectionIteration(*sec, sec->pushed);
+        if(vecCopy(fx, &slot) == LINALG_OK) sec->pushed++;
+        return;
+    }
+
+    Vec tmp = vecCopyA(fx);
+    sec->pushed++;
+
     // simply push to stack
     dynStackPush(&sec->data, &tmp);
 }
 
+PyViNewton pyviNewtonInit(PyVi* pyvi, const char* x_name, const char* residual_name, PyViBase p)
+{
+    PyViNewton newton;
+    newton.x = pyviCreateSection(pyvi, x_name, p);
+    newton.residual = pyviCreateSection(pyvi, residual_name, p);
+
+    return newton;
+}
+
+void pyviNewtonMonitor(void* user, const BlkNewtonIter* iter)
+{
+    PyViNewton* newton = user;
+
+    // Vec2 is two packed doubles, so the blocks are one contiguous 2n vector
+    pyviSectionPush(newton->x, vecConstruct((double*)iter->x, 2 * iter->len));
+    pyviSectionPush(newton->residual, vecConstruct((double*)iter->residual, 2 * iter->len));
+}
+
 void freePyVi(PyVi* pyvi)
 {
     // close the file
-    fclose(pyvi->file);
+    if(pyvi->file) fclose(pyvi->file);
     pyvi->file = NULL;
 
+    freePyViLive(pyvi->live);
+    pyvi->live = NULL;
+
     for(size_t i = 0; i < pyvi->sections.len; i++)
     {
         PyViSectionData* section = dynStackGet(pyvi->sections, i);
@@ -67,6 +381,7 @@ void freePyVi(PyVi* pyvi)
             freeVec(dynStackGet(section->data, j));
         }
         freeDynStack(&section->data);
+        free(section->ring);
     }
 
     freeDynStack(&pyvi->sections);
@@ -82,9 +397,222 @@ void pyviPrintVec(PyVi pyvi, Vec x)
     }
 }
 
+// MSB first bit writer, used by the XOR encoding
+typedef struct PyViBitWriter
+{
+    uint8_t* buffer;
+    size_t pos;
+    uint64_t acc;
+    unsigned bits;
+} PyViBitWriter;
+
+static void pyviBitsWrite(PyViBitWriter* w, uint64_t value, unsigned n)
+{
+    // split wide writes, so acc never holds more than 7 + 32 pending bits
+    if(n > 32)
+    {
+        pyviBitsWrite(w, value >> 32, n - 32);
+        n = 32;
+    }
+    value &= (n == 32) ? 0xffffffffull : ((1ull << n) - 1);
+
+    w->acc = (w->acc << n) | value;
+    w->bits += n;
+    while(w->bits >= 8)
+    {
+        w->bits -= 8;
+        w->buffer[w->pos++] = (uint8_t)(w->acc >> w->bits);
+    }
+}
+
+static void pyviBitsFlush(PyViBitWriter* w)
+{
+    if(w->bits) w->buffer[w->pos++] = (uint8_t)(w->acc << (8 - w->bits));
+    w->bits = 0;
+}
+
+static unsigned pyviLeadingZeros(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_clzll(x);
+#else
+    unsigned n = 0;
+    while(!(x & (1ull << 63))) { x <<= 1; n++; }
+    return n;
+#endif
+}
+
+static unsigned pyviTrailingZeros(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    unsigned n = 0;
+    while(!(x & 1)) { x >>= 1; n++; }
+    return n;
+#endif
+}
+
+static uint64_t pyviDoubleBits(double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+// worst case size of an encoded iteration, 2 + 5 + 6 + 64 bits per value
+#define PYVI_XOR_MAX_BYTES(len) (((len) * 77 + 7) / 8)
+
+// XOR encode x against prev(prev may be nullVec, then x is encoded against zeros)
+// each value is written as(gorilla style):
+// '0'                                  if value is same as in prev
+// '10' + meaningful bits               if xor fits in the previous leading/trailing zero window
+// '11' + 5 bit lead + 6 bit length + meaningful bits otherwise
+// returns number of bytes written to buffer
+static size_t pyviXorEncode(Vec x, Vec prev, uint8_t* buffer)
+{
+    PyViBitWriter w = { buffer, 0, 0, 0 };
+
+    // no window yet, forces the first non zero xor to write its window
+    unsigned prev_lead = 65, prev_trail = 0;
+
+    for(size_t i = 0; i < x.len; i++)
+    {
+        uint64_t cur = pyviDoubleBits(*vecRef(x, i));
+        uint64_t xor = cur ^ (prev.x ? pyviDoubleBits(*vecRef(prev, i)) : 0);
+
+        if(xor == 0)
+        {
+            pyviBitsWrite(&w, 0, 1);
+            continue;
+        }
+
+        unsigned lead = pyviLeadingZeros(xor);
+        unsigned trail = pyviTrailingZeros(xor);
+        // lead is stored in 5 bits
+        if(lead > 31) lead = 31;
+
+        if(prev_lead <= 64 && lead >= prev_lead && trail >= prev_trail)
+        {
+            pyviBitsWrite(&w, 2, 2);
+            pyviBitsWrite(&w, xor >> prev_trail, 64 - prev_lead - prev_trail);
+        }
+        else
+        {
+            unsigned meaningful = 64 - lead - trail;
+            pyviBitsWrite(&w, 3, 2);
+            pyviBitsWrite(&w, lead, 5);
+            // 64 meaningful bits is stored as 0
+            pyviBitsWrite(&w, meaningful & 63, 6);
+            pyviBitsWrite(&w, xor >> trail, meaningful);
+
+            prev_lead = lead;
+            prev_trail = trail;
+        }
+    }
+
+    pyviBitsFlush(&w);
+    return w.pos;
+}
+
+// writes all iterations of a section as text
+// the file offset of every record is pushed to offsets
+static void pyviWriteSectionText(PyVi pyvi, PyViSectionData section, DynStack* offsets)
+{
+    // ring sections only have the last ring_capacity iterations
+    size_t first = pyviSectionFirst(section);
+    for(size_t j = first; j < first + pyviSectionCount(section); j++)
+    {
+        long offset = ftell(pyvi.file);
+        dynStackPush(offsets, &offset);
+
+        fprintf(pyvi.file, "I[%zu]=", j); pyviPrintVec(pyvi, pyviSectionIteration(section, j));
+        fprintf(pyvi.file, "\n");
+    }
+}
+
+// writes all iterations of a section XOR encoded, see pyviSetEncoding
+// falls back to text if the encoding buffer can't be allocated. the file offset of every record is pushed to offsets
+static void pyviWriteSectionXor(PyVi pyvi, PyViSectionData section, DynStack* offsets)
+{
+    size_t first = pyviSectionFirst(section);
+    size_t count = pyviSectionCount(section);
+
+    size_t max_len = 0;
+    for(size_t j = first; j < first + count; j++)
+    {
+        Vec x = pyviSectionIteration(section, j);
+        max_len = max_len > x.len ? max_len : x.len;
+    }
+
+    uint8_t* buffer = malloc(PYVI_XOR_MAX_BYTES(max_len) + 1);
+    if(!buffer)
+    {
+        LINALG_REPORT_WARN("unable to allocate encoding buffer for section %s, it is written as text!", section.name);
+        pyviWriteSectionText(pyvi, section, offsets);
+        return;
+    }
+
+    Vec prev = nullVec;
+    for(size_t j = first; j < first + count; j++)
+    {
+        Vec x = pyviSectionIteration(section, j);
+
+        // restart from zero at keyframes or if the vector size changes
+        int keyframe = ((j - first) % PYVI_XOR_KEYFRAME_INTERVAL == 0) || prev.len != x.len;
+        size_t nbytes = pyviXorEncode(x, keyframe ? nullVec : prev, buffer);
+
+        long offset = ftell(pyvi.file);
+        dynStackPush(offsets, &offset);
+        fprintf(pyvi.file, "%c[%zu]=%zu,%zu\n", keyframe ? 'K' : 'X', j, x.len, nbytes);
+        fwrite(buffer, 1, nbytes, pyvi.file);
+        fprintf(pyvi.file, "\n");
+
+        prev = x;
+    }
+
+    free(buffer);
+}
+
+// writes the offset index, see pyviWrite
+static void pyviWriteIndex(PyVi pyvi, long sections_offset, DynStack offsets)
+{
+    long index_offset = ftell(pyvi.file);
+
+    fprintf(pyvi.file, "[Index]\n");
+    fprintf(pyvi.file, "#sections=%ld\n", sections_offset);
+
+    size_t record = 0;
+    for(size_t i = 0; i < pyvi.sections.len; i++)
+    {
+        PyViSectionData section = *(PyViSectionData*)dynStackGet(pyvi.sections, i);
+
+        // iterations of a section are consecutive, so only the first iteration number is stored
+        size_t count = pyviSectionCount(section);
+        fprintf(pyvi.file, "(%s)->[%s]@%zu=", section.name, section.parameter.name, pyviSectionFirst(section));
+        for(size_t j = 0; j < count; j++, record++)
+        {
+            fprintf(pyvi.file, "%ld", *(long*)dynStackGet(offsets, record));
+            if(j != count - 1) fprintf(pyvi.file, ",");
+        }
+        fprintf(pyvi.file, "\n");
+    }
+
+    // fixed width, so readers can find the index from the last line
+    fprintf(pyvi.file, "[IndexOffset]=%020ld\n", index_offset);
+}
+
 // writes all the data to file
+// the file ends with an index of the byte offset of every (section, iteration) record,
+// so readers can seek directly to the iterations they need
 void pyviWrite(PyVi pyvi)
 {
+    LINALG_TRACE_SCOPE(pyvi.sections.len, pyvi.encoding, 0);
+    // live only
+    if(!pyvi.file) return;
+
+    DynStack/*long*/ offsets = dynStackInitSegmented(sizeof(long), NULL);
+
     // first add all parameters
     fprintf(pyvi.file, "[Parameters]\n");
     for(size_t i = 0; i < pyvi.parameters.len; i++)
@@ -96,22 +624,36 @@ void pyviWrite(PyVi pyvi)
         fprintf(pyvi.file, "\n");
     }
 
+    long sections_offset = ftell(pyvi.file);
     fprintf(pyvi.file, "[Sections]\n");
 
     // then add all sections
+    size_t records = 0;
     for(size_t i = 0; i < pyvi.sections.len; i++)
     {
         PyViSectionData section = *(PyViSectionData*)dynStackGet(pyvi.sections, i);
+        records += pyviSectionCount(section);
         
         fprintf(pyvi.file, "(%s)->[%s]\n", section.name, section.parameter.name);
-        
-        for(size_t j = 0; j < section.data.len; j++)
+
+        if(pyvi.encoding == PYVI_ENCODING_XOR)
         {
-            fprintf(pyvi.file, "I[%zu]=", j); pyviPrintVec(pyvi, *(Vec*)dynStackGet(section.data, j));
+            pyviWriteSectionXor(pyvi, section, &offsets);
             fprintf(pyvi.file, "\n");
+            continue;
         }
+
+        pyviWriteSectionText(pyvi, section, &offsets);
         fprintf(pyvi.file, "\n");
     }
+
+    // a failed push would point the index at the wrong records, a file without index is still readable
+    if(offsets.len == records) pyviWriteIndex(pyvi, sections_offset, offsets);
+    else
+    {
+        LINALG_REPORT_ERROR("unable to record the offsets of all iterations, the index is not written!");
+    }
+    freeDynStack(&offsets);
 }
 
 
@@ -6,17 +6,163 @@
 #define __DSTACK_GET(dstack, x) dstack.data[dstack.element_size * x]
 #define __DSTACK_PTR_GET(dstack, x) dstack->data[dstack->element_size * x]
 
+// alignment of arena allocations
+#define __DARENA_ALIGN 16
+
+typedef struct DynArenaBlock
+{
+    struct DynArenaBlock* next;
+    size_t used;
+    size_t size;
+    // aligns the data that follows to __DARENA_ALIGN
+    _Alignas(__DARENA_ALIGN) uint8_t data[];
+} DynArenaBlock;
+
+// make a empty arena, blocks are allocated block_size bytes at a time
+DynArena dynArenaInit(size_t block_size)
+{
+    return (DynArena){NULL, block_size};
+}
+
+// allocate size bytes from the arena(aligned to 16 bytes), returns NULL on failiure
+void* dynArenaAlloc(DynArena* arena, size_t size)
+{
+    size = (size + __DARENA_ALIGN - 1) & ~(size_t)(__DARENA_ALIGN - 1);
+
+    DynArenaBlock* block = arena->blocks;
+    if(!block || block->size - block->used < size)
+    {
+        // oversized requests get a block of their own
+        size_t block_size = arena->block_size > size ? arena->block_size : size;
+        block = malloc(sizeof(DynArenaBlock) + block_size);
+        if(!block)
+        {
+            printf("[Dyn Arena] Fatal Error: malloc returned null!\n");
+            return NULL;
+        }
+        block->used = 0;
+        block->size = block_size;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+// free all memory owned by the arena
+void freeDynArena(DynArena* arena)
+{
+    DynArenaBlock* block = arena->blocks;
+    while(block)
+    {
+        DynArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+}
+
+// index of the highest set bit, x must not be zero
+static size_t __dstackLog2(size_t x)
+{
+#if defined(__GNUC__)
+    return (size_t)(63 - __builtin_clzll((unsigned long long)x));
+#else
+    size_t n = 0;
+    while(x >>= 1) n++;
+    return n;
+#endif
+}
+
+// number of elements that fit in the first k chunks of a segmented stack
+#define __DSTACK_CHUNKS_CAPACITY(k) ((size_t)DYNSTACK_FIRST_CHUNK * (((size_t)1 << (k)) - 1))
+
+// chunk k holds DYNSTACK_FIRST_CHUNK << k elements, so chunk k starts at element __DSTACK_CHUNKS_CAPACITY(k)
+static uint8_t* __dstackSegmentedGet(DynStack dstack, size_t index)
+{
+    size_t k = __dstackLog2(index / DYNSTACK_FIRST_CHUNK + 1);
+    return dstack.chunks[k] + dstack.element_size * (index - __DSTACK_CHUNKS_CAPACITY(k));
+}
+
+// add chunks until the stack can hold new_len elements
+static void __dstackSegmentedReserve(DynStack* dstack, size_t new_len)
+{
+    if(!dstack->chunks)
+    {
+        dstack->chunks = calloc(DYNSTACK_MAX_CHUNKS, sizeof(uint8_t*));
+        if(!dstack->chunks)
+        {
+            printf("[Dyn Stack] Fatal Error: calloc returned null!\n");
+            return;
+        }
+    }
+
+    // reserved_size is always the capacity of the allocated chunks
+    size_t k = __dstackLog2(dstack->reserved_size / DYNSTACK_FIRST_CHUNK + 1);
+    while(dstack->reserved_size < new_len && k < DYNSTACK_MAX_CHUNKS)
+    {
+        size_t bytes = dstack->element_size * ((size_t)DYNSTACK_FIRST_CHUNK << k);
+        dstack->chunks[k] = dstack->arena ? dynArenaAlloc(dstack->arena, bytes) : malloc(bytes);
+
+        if(!dstack->chunks[k])
+        {
+            printf("[Dyn Stack] Fatal Error: chunk allocation returned null!\n");
+            return;
+        }
+
+        k++;
+        dstack->reserved_size = __DSTACK_CHUNKS_CAPACITY(k);
+    }
+}
+
 // make a empty dyn stack
 DynStack dynStackInit(size_t elem_len)
 {
-    return (DynStack){NULL, 0, 0, elem_len};
+    return (DynStack){NULL, 0, 0, elem_len, NULL, NULL, 0};
+}
+// make a empty segmented dyn stack
+DynStack dynStackInitSegmented(size_t elem_len, DynArena* arena)
+{
+    return (DynStack){NULL, 0, 0, elem_len, NULL, arena, 1};
+}
+// Reserve space for at least new_len elements
+void dynStackReserve(DynStack* dstack, size_t new_len)
+{
+    if(dstack->reserved_size >= new_len) return;
+
+    if(dstack->segmented)
+    {
+        __dstackSegmentedReserve(dstack, new_len);
+        return;
+    }
+
+    uint8_t* data = realloc(dstack->data, dstack->element_size * new_len);
+    if(!data)
+    {
+        printf("[Dyn Stack] Fatal Error: realloc returned null!\n");
+        return;
+    }
+
+    dstack->data = data;
+    dstack->reserved_size = new_len;
 }
-// Reserve N element space
-//DynStack dynStackReserve(size_t new_len);
 
 // push element_size data to stack, WARNING: assumes data is element_size large!
 void dynStackPush(DynStack* dstack, void* data)
 {
+    if(dstack->segmented)
+    {
+        // a new chunk is only needed once every doubling, existing elements never move
+        if(dstack->reserved_size < dstack->len + 1) __dstackSegmentedReserve(dstack, dstack->len + 1);
+        if(dstack->reserved_size < dstack->len + 1) return;
+
+        memcpy(__dstackSegmentedGet(*dstack, dstack->len), data, dstack->element_size);
+        dstack->len++;
+        return;
+    }
+
     // if we have enough reserve space then, simply copy the data onto stack
     if(dstack->reserved_size < dstack->len + 1)
     {
@@ -33,10 +179,47 @@ void dynStackPush(DynStack* dstack, void* data)
     dstack->len++;
 }
 
+// push n elements to stack, WARNING: assumes data is n * element_size large!
+void dynStackPushN(DynStack* dstack, const void* data, size_t n)
+{
+    if(n == 0) return;
+
+    if(dstack->reserved_size < dstack->len + n)
+    {
+        // grow geometrically, so repeated bulk pushes stay amortized O(1) per element
+        size_t new_len = 2 * dstack->reserved_size;
+        dynStackReserve(dstack, new_len > dstack->len + n ? new_len : dstack->len + n);
+        if(dstack->reserved_size < dstack->len + n) return;
+    }
+
+    const uint8_t* src = data;
+
+    if(!dstack->segmented)
+    {
+        memcpy(&__DSTACK_PTR_GET(dstack, dstack->len), src, dstack->element_size * n);
+        dstack->len += n;
+        return;
+    }
+
+    // copy chunk by chunk
+    while(n > 0)
+    {
+        size_t k = __dstackLog2(dstack->len / DYNSTACK_FIRST_CHUNK + 1);
+        size_t room = __DSTACK_CHUNKS_CAPACITY(k + 1) - dstack->len;
+        size_t count = room < n ? room : n;
+
+        memcpy(__dstackSegmentedGet(*dstack, dstack->len), src, dstack->element_size * count);
+
+        src += dstack->element_size * count;
+        dstack->len += count;
+        n -= count;
+    }
+}
+
 // access a element in dyn stack, safely
 void* dynStackGet(DynStack dstack, size_t index)
 {
-    if (index < dstack.len) return &__DSTACK_GET(dstack, index);
+    if (index < dstack.len) return dstack.segmented ? __dstackSegmentedGet(dstack, index) : &__DSTACK_GET(dstack, index);
     else
     {
         printf("[Dyn Stack] Warning: attempt to access index %zu in stack of size %zu!\n", index, dstack.len);
@@ -55,6 +238,16 @@ void freeDynStack(DynStack* dstack)
 {
     if(dstack->data) free(dstack->data);
 
+    if(dstack->chunks)
+    {
+        // arena chunks are released with the arena
+        if(!dstack->arena)
+        {
+            for(size_t k = 0; k < DYNSTACK_MAX_CHUNKS; k++) free(dstack->chunks[k]);
+        }
+        free(dstack->chunks);
+    }
+
     // empty out the dstack
     *dstack = dynStackInit(0);
 }
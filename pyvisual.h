@@ -12,11 +12,31 @@ typedef struct PyViBase
     Vec axis;
 } PyViBase;
 
+// how section iterations are stored in the file
+typedef enum PyViEncoding
+{
+    // every iteration is written in full as text(default)
+    PYVI_ENCODING_TEXT = 0,
+    // lossless, every iteration is XORed against the previous one and bit-packed(gorilla style)
+    // see pyviSetEncoding for details
+    PYVI_ENCODING_XOR = 1
+} PyViEncoding;
+
+// every PYVI_XOR_KEYFRAME_INTERVAL iterations, XOR encoding restarts from zero
+// so a reader never has to decode more than this many iterations to reach any one
+#define PYVI_XOR_KEYFRAME_INTERVAL 64
+
+// live view of the latest iteration of every section in POSIX shared memory, see pyviLiveStart
+typedef struct PyViLive PyViLive;
+
 typedef struct PyVi
 {
     FILE* file;
     DynStack/*PyViSection*/ sections;
     DynStack/*PyViParameter*/ parameters;
+    PyViEncoding encoding;
+    // NULL unless pyviLiveStart was called
+    PyViLive* live;
 } PyVi;
 
 typedef struct PyViSec
@@ -25,9 +45,14 @@ typedef struct PyViSec
     PyVi* pyvi;
 } PyViSec;
 
+// filename NULL makes a live only PyVi(see pyviLiveStart), pushed iterations are then published but not stored
 PyVi pyviInitA(const char* filename);
 
 PyViSec pyviCreateSection(PyVi* pyvi, const char* section_name, PyViBase p);
+// create a section that only retains the last capacity iterations
+// storage is one preallocated slab of capacity x p.axis.len doubles, the oldest iteration is overwritten in place
+// pushed vectors must be p.axis.len long, pyviWrite emits only the retained iterations(with their original numbers)
+PyViSec pyviCreateSectionRing(PyVi* pyvi, const char* section_name, PyViBase p, size_t capacity);
 
 // Copies p by reference. DO NOT FREE p BEFORE PYVI is freed
 PyViBase pyviCreateParameter(PyVi* pyvi, const char* param_name, Vec p);
@@ -35,6 +60,40 @@ PyViBase pyviCreateParameter(PyVi* pyvi, const char* param_name, Vec p);
 // push a vector fx varying with parameter x, copies the vector
 void pyviSectionPush(PyViSec section, Vec fx);
 
+// records the iterations of blkTriDiagNewton, see pyviNewtonMonitor
+typedef struct PyViNewton
+{
+    PyViSec x;
+    PyViSec residual;
+} PyViNewton;
+
+// sections for the iterate and the residual of every newton iteration, both flattened to 2n values over p
+PyViNewton pyviNewtonInit(PyVi* pyvi, const char* x_name, const char* residual_name, PyViBase p);
+// BlkNewtonMonitorFn pushing an iteration, set opts.monitor_user to a PyViNewton*
+void pyviNewtonMonitor(void* user, const BlkNewtonIter* iter);
+
+// names(including the nul) longer than this are truncated in the live segment
+#define PYVI_LIVE_NAME_LEN 40
+
+// publish the latest iteration of every section to the POSIX shared memory segment shm_name(e.g. "/solver")
+// call it after all parameters and sections are created, pyviSectionPush then also copies the vector into the segment
+// the segment is unlinked by freePyVi, pyvisual.py PyViLive maps it and plots it while the solver runs
+// layout(native byte order, 64 byte header and entries):
+// header:  "PYVILIV1", uint64 size, uint64 parameters, uint64 sections, 32 reserved bytes
+// entries: one per parameter and then one per section, char name[PYVI_LIVE_NAME_LEN], uint64 param(index of the
+//          parameter of a section, UINT64_MAX if unknown), uint64 len, uint64 offset of the data
+// parameter data: len doubles
+// section data: uint64 seq, uint64 iteration, uint64 count, 40 pad bytes, len doubles(the first count are valid)
+// seq is a seqlock: odd while a snapshot is written, readers retry if it is odd or changed while they copied
+// returns LINALG_ERROR if the segment can not be created(or on platforms without shm_open)
+int pyviLiveStart(PyVi* pyvi, const char* shm_name);
+
+// set how iterations are encoded by pyviWrite, default is PYVI_ENCODING_TEXT
+// PYVI_ENCODING_XOR writes each iteration as binary:
+// K[iter]=len,nbytes\n<nbytes of payload>\n for keyframes(XORed against zeros)
+// X[iter]=len,nbytes\n<nbytes of payload>\n for deltas(XORed against previous iteration)
+void pyviSetEncoding(PyVi* pyvi, PyViEncoding encoding);
+
 // writes all the data to file
 void pyviWrite(PyVi pyvi);
 
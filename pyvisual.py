@@ -5,8 +5,11 @@ from matplotlib.widgets import Button
 from functools import partial
 
 from typing import List, Dict
+from collections import OrderedDict
 
+import mmap
 import re
+import time
 
 class PyVi:
     class PyViSection:
@@ -24,39 +27,197 @@ class PyVi:
                 plt.xlabel(self.param)
                 plt.ylabel(self.name)
 
+    # MSB first bit reader, mirrors PyViBitWriter in pyvi-src/pyvisual.c
+    class BitReader:
+        def __init__(self, data : bytes):
+            self.data = data
+            self.pos = 0
+
+        def read(self, n):
+            if n == 0:
+                return 0
+            start = self.pos >> 3
+            end = (self.pos + n + 7) >> 3
+            chunk = int.from_bytes(self.data[start:end], 'big')
+            shift = (end - start) * 8 - (self.pos & 7) - n
+            self.pos += n
+            return (chunk >> shift) & ((1 << n) - 1)
+
+    # decode a PYVI_ENCODING_XOR iteration, prev is the previous iteration as uint64 bits(None for keyframes)
+    @staticmethod
+    def decode_xor(payload : bytes, length : int, prev):
+        reader = PyVi.BitReader(payload)
+        xors = np.zeros(length, dtype=np.uint64)
+        lead, trail = 0, 0
+        for i in range(length):
+            if reader.read(1) == 0:
+                continue
+            if reader.read(1) == 1:
+                lead = reader.read(5)
+                meaningful = reader.read(6)
+                if meaningful == 0:
+                    meaningful = 64
+                trail = 64 - lead - meaningful
+            xors[i] = reader.read(64 - lead - trail) << trail
+        if prev is not None:
+            xors ^= prev
+        return xors
+
+    # reads the line at pos, returns (line, position after the line)
+    @staticmethod
+    def read_line(data, pos):
+        end = data.find(b'\n', pos)
+        if end == -1:
+            end = len(data)
+        return data[pos:end].decode('ascii', errors='replace'), end + 1
+
+    # decodes the iteration record at pos, prev_bits is the previous iteration of the
+    # section as uint64 bits(needed for X records), returns (kind, iteration, values, next_pos)
+    # or None if there is no record at pos
+    @staticmethod
+    def read_record(data, pos, prev_bits=None):
+        line, pos = PyVi.read_line(data, pos)
+
+        # XOR encoded iteration, payload follows the header line
+        if m := re.match(r'([KX])\[(\d+)\]\=(\d+),(\d+)', line):
+            length, nbytes = int(m.group(3)), int(m.group(4))
+            payload = data[pos:pos + nbytes]
+            prev = prev_bits if m.group(1) == 'X' else None
+            bits = PyVi.decode_xor(payload, length, prev)
+            return m.group(1), int(m.group(2)), bits.view(np.float64), pos + nbytes + 1
+
+        if m := re.match(r'I\[(\d+)\]\=(.*)', line):
+            return 'I', int(m.group(1)), np.fromstring(m.group(2), dtype=np.float64, sep=','), pos
+
+        return None
+
+    # iterations of a section in an indexed file, behaves like a read only dict
+    # iterations are decoded on first access and kept in a small LRU cache
+    class LazyIterations:
+        CACHE_SIZE = 32
+
+        def __init__(self, data, first, offsets):
+            self.data = data
+            self.first = first
+            self.offsets = offsets
+            self.cache = OrderedDict()
+
+        def __len__(self):
+            return len(self.offsets)
+
+        def __contains__(self, k):
+            return self.first <= k < self.first + len(self.offsets)
+
+        def keys(self):
+            return range(self.first, self.first + len(self.offsets))
+
+        def __iter__(self):
+            return iter(self.keys())
+
+        def __kind(self, k):
+            pos = int(self.offsets[k - self.first])
+            return chr(self.data[pos])
+
+        def __store(self, k, values):
+            self.cache[k] = values
+            self.cache.move_to_end(k)
+            while len(self.cache) > PyVi.LazyIterations.CACHE_SIZE:
+                self.cache.popitem(last=False)
+
+        def __getitem__(self, k):
+            if k not in self:
+                raise KeyError(k)
+            if k in self.cache:
+                self.cache.move_to_end(k)
+                return self.cache[k]
+
+            # X records depend on the previous iteration, walk back to a keyframe(or a cached iteration)
+            start = k
+            while self.__kind(start) == 'X' and (start - 1) not in self.cache:
+                start -= 1
+
+            prev_bits = None
+            if self.__kind(start) == 'X':
+                prev_bits = self.cache[start - 1].view(np.uint64)
+
+            for i in range(start, k + 1):
+                _, _, values, _ = PyVi.read_record(self.data, int(self.offsets[i - self.first]), prev_bits)
+                self.__store(i, values)
+                prev_bits = values.view(np.uint64)
+
+            return self.cache[k]
+
+    # loads sections lazily using the offset index at the end of the file
+    # returns False if the file has no index
+    def __load_index(self, data):
+        m = re.search(rb'\[IndexOffset\]=(\d+)\n?$', data[max(0, len(data) - 64):])
+        if not m:
+            return False
+
+        pos = int(m.group(1))
+        line, pos = PyVi.read_line(data, pos)
+        if line != '[Index]':
+            return False
+
+        sections_offset = 0
+        while pos < len(data):
+            line, pos = PyVi.read_line(data, pos)
+            if m := re.match(r'#sections=(\d+)', line):
+                sections_offset = int(m.group(1))
+            elif m := re.match(r'\((.*?)\)\-\>\[(.*?)\]@(\d+)=(.*)', line):
+                section = PyVi.PyViSection(m.group(1), m.group(2))
+                offsets = np.fromstring(m.group(4), dtype=np.int64, sep=',') if m.group(4) else []
+                section.iterations = PyVi.LazyIterations(data, int(m.group(3)), offsets)
+                self.sections[m.group(1)] = section
+
+        # parameters are stored before the sections
+        pos = 0
+        while pos < sections_offset:
+            line, pos = PyVi.read_line(data, pos)
+            if not line.startswith('[') and (m := re.match(r'(.*?):(.*)', line)):
+                self.params[m.group(1)] = np.fromstring(m.group(2), dtype=np.float64, sep=',')
+
+        return True
+
     def __load_from_file(self, file):
-        with open(file) as f:
-            lines = f.readlines()
+        with open(file, 'rb') as f:
+            data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if self.__load_index(data):
+            # keep the mapping alive, iterations are decoded from it on demand
+            self.data = data
+            return
 
-            GLOBAL_MODE = 0
-            PARAMETER_MODE = 1
-            SECTION_MODE = 2
-            SECTION_MODE_VEC = 3
+        # no index, decode everything
+        current_section = ''
+        prev_bits = None
 
-            state = GLOBAL_MODE
+        pos = 0
+        while pos < len(data):
+            if record := PyVi.read_record(data, pos, prev_bits):
+                _, iteration, values, pos = record
+                self.sections[current_section].iterations[iteration] = values
+                prev_bits = values.view(np.uint64)
+                continue
 
-            current_section = ''
+            line, pos = PyVi.read_line(data, pos)
 
-            for line in lines:
-                if m := re.match(r'\[(.*?)\]', line):
-                    if m.group(1) == 'Parameter':    
-                        state = PARAMETER_MODE
-                    elif m.group(1) == 'Section':
-                        state = SECTION_MODE
-                    continue
-                
-                if m := re.match(r'(.*?):(.*)', line):
-                    self.params[m.group(1)] = np.fromstring(m.group(2), dtype=np.float64, sep=',')
-                
-                if m := re.match(r'\((.*?)\)\-\>\[(.*?)\]', line):
-                    self.sections[m.group(1)] = PyVi.PyViSection(m.group(1), m.group(2))
-                    current_section = m.group(1)
-                    state = SECTION_MODE_VEC
-                
-                if m := re.match(r'I\[(\d+)\]\=(.*)', line):
-                    self.sections[current_section].parse_line(m.group(1), m.group(2))
+            if line == '[Index]':
+                break
+
+            if m := re.match(r'\[(.*?)\]', line):
+                continue
+
+            if m := re.match(r'(.*?):(.*)', line):
+                self.params[m.group(1)] = np.fromstring(m.group(2), dtype=np.float64, sep=',')
+            
+            if m := re.match(r'\((.*?)\)\-\>\[(.*?)\]', line):
+                self.sections[m.group(1)] = PyVi.PyViSection(m.group(1), m.group(2))
+                current_section = m.group(1)
+                prev_bits = None
 
     def __init__(self, filename):
+        self.data = None
         self.params : Dict[str, np.ndarray] = {}
         self.sections : Dict[str, PyVi.PyViSection] = {}
         self.__load_from_file(filename)
@@ -100,10 +261,12 @@ class PyVi:
     # displays all sections 
     def display_all_sections(self):
         self.curr_i = 0
-        self.curr_iter = 0
 
         self.keys = list(self.sections.keys())
 
+        # ring sections do not start at iteration 0
+        self.curr_iter = next(iter(self.sections[self.keys[0]].iterations), 0)
+
         fig, ax = plt.subplots() 
         fig.subplots_adjust(bottom=0.22)
 
@@ -169,3 +332,106 @@ class PyVi:
 
         plt.show()
 
+
+# live view of a running solver, reads the shared memory segment of pyviLiveStart(see pyvisual.h for the layout)
+class PyViLive:
+    MAGIC = b'PYVILIV1'
+    HEADER_SIZE = 64
+    ENTRY = np.dtype([('name', 'S40'), ('param', '=u8'), ('len', '=u8'), ('offset', '=u8')])
+    NO_PARAM = np.iinfo(np.uint64).max
+
+    class LiveSection:
+        def __init__(self, name, param, data, offset, length):
+            self.name = name
+            self.param = param
+            # seq, iteration, count
+            self.header = np.frombuffer(data, dtype=np.uint64, count=3, offset=offset)
+            self.values = np.frombuffer(data, dtype=np.float64, count=length, offset=offset + 64)
+
+        # latest published (iteration, values), values are a copy. None if nothing was published yet
+        def snapshot(self):
+            spins = 0
+            while True:
+                seq = int(self.header[0])
+                if seq == 0:
+                    return None
+                if seq & 1 == 0:
+                    iteration, count = int(self.header[1]), int(self.header[2])
+                    values = self.values[:count].copy()
+                    # the writer did not touch the slot while we copied
+                    if int(self.header[0]) == seq:
+                        return iteration, values
+                spins += 1
+                if spins % 64 == 0:
+                    time.sleep(0.0005)
+
+    # name as given to pyviLiveStart, the segment is mapped from /dev/shm
+    def __init__(self, name, timeout=10.0):
+        path = '/dev/shm/' + name.lstrip('/')
+
+        # the solver may not have started yet
+        deadline = time.time() + timeout
+        while True:
+            try:
+                with open(path, 'rb') as f:
+                    self.data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+                if self.data[0:8] == PyViLive.MAGIC:
+                    break
+                self.data.close()
+            except (FileNotFoundError, ValueError):
+                pass
+            if time.time() > deadline:
+                raise TimeoutError(f'no live PyVi segment {name}')
+            time.sleep(0.1)
+
+        _, nparams, nsections = np.frombuffer(self.data, dtype=np.uint64, count=3, offset=8)
+        entries = np.frombuffer(self.data, dtype=PyViLive.ENTRY, count=int(nparams + nsections), offset=PyViLive.HEADER_SIZE)
+
+        self.params : Dict[str, np.ndarray] = {}
+        names = []
+        for entry in entries[:nparams]:
+            name = entry['name'].decode('ascii', errors='replace')
+            names.append(name)
+            self.params[name] = np.frombuffer(self.data, dtype=np.float64, count=int(entry['len']), offset=int(entry['offset'])).copy()
+
+        self.sections : Dict[str, PyViLive.LiveSection] = {}
+        for entry in entries[nparams:]:
+            name = entry['name'].decode('ascii', errors='replace')
+            param = names[int(entry['param'])] if entry['param'] != PyViLive.NO_PARAM else None
+            self.sections[name] = PyViLive.LiveSection(name, param, self.data, int(entry['offset']), int(entry['len']))
+
+    def snapshot(self, section_name):
+        return self.sections[section_name].snapshot()
+
+    # plot every section in its own axes, refreshed every interval milliseconds until the window is closed
+    def display_live(self, interval=200):
+        from matplotlib.animation import FuncAnimation
+
+        keys = list(self.sections.keys())
+        fig, axes = plt.subplots(len(keys), 1, squeeze=False)
+        lines = []
+        for i, key in enumerate(keys):
+            section = self.sections[key]
+            ax = axes[i][0]
+            ccolor = mcolors.TABLEAU_COLORS[list(mcolors.TABLEAU_COLORS.keys())[i % len(mcolors.TABLEAU_COLORS)]]
+            p, = ax.plot([], [], color=ccolor)
+            ax.set_xlabel(f'{section.param}')
+            ax.set_ylabel(f'{section.name}')
+            lines.append((ax, p, section))
+
+        def refresh(frame):
+            for ax, p, section in lines:
+                snap = section.snapshot()
+                if snap is None:
+                    continue
+                iteration, values = snap
+                param = self.params[section.param][:len(values)] if section.param in self.params else np.arange(len(values))
+                p.set_data(param, values)
+                ax.relim()
+                ax.autoscale_view(True, True, True)
+                ax.title.set_text(f'{section.name} at iteration={iteration}')
+            return [p for _, p, _ in lines]
+
+        # keep a reference, the animation stops when it is garbage collected
+        self.animation = FuncAnimation(fig, refresh, interval=interval, cache_frame_data=False)
+        plt.show()
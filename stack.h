@@ -3,26 +3,64 @@
 #include <stdio.h>
 #include <stdint.h>
 
+// a simple bump allocator, memory is only released when the whole arena is freed
+// useful as backing for many segmented dyn stacks that live and die together
+typedef struct DynArena
+{
+    // linked list of blocks, newest first
+    struct DynArenaBlock* blocks;
+    // default size of a new block
+    size_t block_size;
+} DynArena;
+
+// make a empty arena, blocks are allocated block_size bytes at a time
+DynArena dynArenaInit(size_t block_size);
+
+// allocate size bytes from the arena(aligned to 16 bytes), returns NULL on failiure
+void* dynArenaAlloc(DynArena* arena, size_t size);
+
+// free all memory owned by the arena, every pointer handed out by it is invalid after this
+void freeDynArena(DynArena* arena);
+
+// number of elements in the first chunk of a segmented dyn stack, chunk k holds DYNSTACK_FIRST_CHUNK << k elements
+#define DYNSTACK_FIRST_CHUNK 16
+// enough chunks to address any 64 bit index
+#define DYNSTACK_MAX_CHUNKS 60
+
 typedef struct DynStack
 {
+    // contiguous storage
     uint8_t* data;
     size_t len;
     size_t reserved_size;
     size_t element_size;
+
+    // segmented storage(chunk table), NULL for contiguous stacks
+    uint8_t** chunks;
+    // if set, chunks are allocated from this arena and freed with it
+    DynArena* arena;
+    int segmented;
 } DynStack;
 
 // make a empty dyn stack
+// grows by realloc, so pointers from dynStackGet are invalidated by a push
 DynStack dynStackInit(size_t elem_len);
-// Reserve N element space
-DynStack dynStackReserve(size_t new_len);
+// make a empty segmented dyn stack
+// grows by adding chunks, so element addresses are stable and a push never copies
+// arena is optional(NULL to allocate chunks with malloc)
+DynStack dynStackInitSegmented(size_t elem_len, DynArena* arena);
+// Reserve space for at least new_len elements
+void dynStackReserve(DynStack* dstack, size_t new_len);
 
 // push element_size data to stack, WARNING: assumes data is element_size large!
 void dynStackPush(DynStack* dstack, void* data);
+// push n elements to stack, WARNING: assumes data is n * element_size large!
+void dynStackPushN(DynStack* dstack, const void* data, size_t n);
 
 // access a element in dyn stack, safely
 void* dynStackGet(DynStack dstack, size_t index);
 
-// clear the stack
+// clear the stack(keeps the reserved space)
 void dynStackClear(DynStack* dstack);
 
 // free a dyn stack, WARNING: Free memory in the dstack before freeing the stack